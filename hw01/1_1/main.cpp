@@ -41,7 +41,27 @@ NO
 */
 
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <sys/mman.h>
+#include <unistd.h>
 
 class Queue {
   public:
@@ -53,6 +73,12 @@ class Queue {
     void push(int value);
     // Извлечение
     int pop();
+    // Количество элементов в очереди
+    int count() const;
+    // Добавление n элементов подряд
+    void push_n(const int* values, int n);
+    // Извлечение n элементов подряд, в очереди должно быть не меньше n
+    void pop_n(int* values, int n);
 
   private:
     // Начальный размер буфера
@@ -110,6 +136,69 @@ int Queue::pop() {
   return result;
 }
 
+int Queue::count() const {
+  if (empty()) {
+    return 0;
+  }
+  if (head <= tail) {
+    return tail - head + 1;
+  }
+  return size - head + tail + 1;
+}
+
+void Queue::push_n(const int* values, int n) {
+  if (n <= 0) {
+    return;
+  }
+  int elements_count = count();
+  if (elements_count + n > size) {
+    // Сразу выделяем буфер нужного размера и переносим в его начало
+    // текущие элементы (increase_buffer рассчитан на полный буфер)
+    int new_size = size;
+    while (new_size < elements_count + n) {
+      new_size *= 2;
+    }
+    int* new_buffer = new int[new_size];
+    pop_n(new_buffer, elements_count);
+    delete[] buffer;
+    buffer = new_buffer;
+    size = new_size;
+    if (elements_count > 0) {
+      head = 0;
+      tail = elements_count - 1;
+    }
+  }
+  int start = 0;
+  if (empty()) {
+    head = 0;
+  } else {
+    start = (tail + 1) % size;
+  }
+  // Копируем не больше двух непрерывных кусков:
+  // до конца буфера и с его начала
+  int first_span = std::min(n, size - start);
+  memcpy(buffer + start, values, sizeof(int) * first_span);
+  memcpy(buffer, values + first_span, sizeof(int) * (n - first_span));
+  tail = (start + n - 1) % size;
+}
+
+void Queue::pop_n(int* values, int n) {
+  if (n <= 0) {
+    return;
+  }
+  int elements_count = count();
+  assert(n <= elements_count);
+  int first_span = std::min(n, size - head);
+  memcpy(values, buffer + head, sizeof(int) * first_span);
+  memcpy(values + first_span, buffer, sizeof(int) * (n - first_span));
+  if (n == elements_count) {
+    // Забрали все элементы
+    head = tail = -1;
+  } else {
+    head = (head + n) % size;
+  }
+}
+
 void Queue::increase_buffer() {
   // Выделяем память под новый буфер
   int* new_buffer = new int[size * 2];
@@ -135,35 +224,747 @@ void Queue::increase_buffer() {
   buffer = new_buffer;
 }
 
-int main() {
-  int commands_count = 0;
-  std::cin >> commands_count;
-  // Флаг останется равным true, если все ожидаемые значения совпадут
-  bool expected_value_flag = true;
-  Queue queue;
+// Очередь с ограниченным буфером в памяти.
+// Пока в памяти меньше memory_limit элементов, работает как Queue.
+// Дальше новые элементы пишутся в сегменты - отображенные в память
+// временные файлы по segment_size элементов. Когда буфер в памяти
+// пустеет, элементы подгружаются из самого старого сегмента.
+// Отображены одновременно не больше двух сегментов (первый и последний),
+// поэтому потребление памяти ограничено независимо от длины очереди.
+class SpillingQueue {
+  public:
+    SpillingQueue(int memory_limit, int segment_size,
+                  const std::string& spill_directory = "/tmp");
+    ~SpillingQueue();
 
-  for (int i = 0; i < commands_count; ++i) {
-    int command = 0;
-    int value = 0;
-    std::cin >> command >> value;
-    if (command == 3) {
-      queue.push(value);
-    } else if (command == 2) {
-      // Проверка на пустоту, чтобы не вызывать pop для пустой очереди
-      if (queue.empty()) {
+    SpillingQueue(const SpillingQueue&) = delete;
+    SpillingQueue& operator=(const SpillingQueue&) = delete;
+
+    // Проверка очереди на пустоту
+    bool empty() const;
+    // Количество элементов в памяти и на диске
+    long long count() const;
+    // Добавление элемента
+    void push(int value);
+    // Извлечение
+    int pop();
+
+  private:
+    // Временный файл с частью очереди
+    struct Segment {
+      int fd = -1;
+      // Отображение файла, nullptr если сейчас не отображен
+      int* data = nullptr;
+      // Сколько записано и сколько уже прочитано
+      int written = 0;
+      int read = 0;
+    };
+
+    // Создание нового сегмента в конце
+    void add_segment();
+    void map_segment(Segment* segment);
+    void unmap_segment(Segment* segment);
+    // Перенос элементов из первого сегмента в буфер в памяти
+    void refill();
+
+    Queue ring;
+    int memory_limit = 0;
+    int segment_size = 0;
+    std::string spill_directory;
+    std::deque<Segment> segments;
+    long long spilled_count = 0;
+};
+
+SpillingQueue::SpillingQueue(int _memory_limit, int _segment_size,
+                             const std::string& _spill_directory)
+    : memory_limit(_memory_limit), segment_size(_segment_size),
+      spill_directory(_spill_directory) {
+  assert(memory_limit > 0);
+  assert(segment_size > 0);
+}
+
+SpillingQueue::~SpillingQueue() {
+  for (Segment& segment : segments) {
+    unmap_segment(&segment);
+    close(segment.fd);
+  }
+}
+
+bool SpillingQueue::empty() const {
+  return ring.empty() && spilled_count == 0;
+}
+
+long long SpillingQueue::count() const {
+  return ring.count() + spilled_count;
+}
+
+void SpillingQueue::add_segment() {
+  std::string path = spill_directory + "/queue-spill-XXXXXX";
+  Segment segment;
+  segment.fd = mkstemp(&path[0]);
+  if (segment.fd == -1) {
+    throw std::system_error(errno, std::generic_category(), "mkstemp");
+  }
+  // Файл нужен только через дескриптор, удалим его сразу,
+  // тогда место на диске освободится и при аварийном завершении
+  unlink(path.c_str());
+  if (ftruncate(segment.fd, sizeof(int) * segment_size) == -1) {
+    int error = errno;
+    close(segment.fd);
+    throw std::system_error(error, std::generic_category(), "ftruncate");
+  }
+  segments.push_back(segment);
+}
+
+void SpillingQueue::map_segment(Segment* segment) {
+  if (segment->data) {
+    return;
+  }
+  void* data = mmap(nullptr, sizeof(int) * segment_size,
+                    PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+  if (data == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(), "mmap");
+  }
+  segment->data = static_cast<int*>(data);
+}
+
+void SpillingQueue::unmap_segment(Segment* segment) {
+  if (segment->data) {
+    munmap(segment->data, sizeof(int) * segment_size);
+    segment->data = nullptr;
+  }
+}
+
+void SpillingQueue::push(int value) {
+  // Пока есть сегменты, пишем только в них, чтобы не нарушить порядок
+  if (segments.empty() && ring.count() < memory_limit) {
+    ring.push(value);
+    return;
+  }
+  if (segments.empty() || segments.back().written == segment_size) {
+    // Заполненный сегмент больше не нужен в памяти,
+    // если только из него сейчас не читают
+    if (segments.size() > 1) {
+      unmap_segment(&segments.back());
+    }
+    add_segment();
+  }
+  Segment& segment = segments.back();
+  map_segment(&segment);
+  segment.data[segment.written++] = value;
+  spilled_count++;
+}
+
+void SpillingQueue::refill() {
+  Segment& segment = segments.front();
+  map_segment(&segment);
+  int batch = std::min(segment.written - segment.read, memory_limit);
+  ring.push_n(segment.data + segment.read, batch);
+  segment.read += batch;
+  spilled_count -= batch;
+  // Прочитанный до конца и больше не пополняемый сегмент удаляем
+  if (segment.read == segment_size) {
+    unmap_segment(&segment);
+    close(segment.fd);
+    segments.pop_front();
+  }
+}
+
+int SpillingQueue::pop() {
+  // Проверка на пустоту
+  assert(!empty());
+  if (ring.empty()) {
+    refill();
+  }
+  return ring.pop();
+}
+
+// Дек из блоков фиксированного размера и карты указателей на блоки.
+// При росте перекладываются только указатели в карте,
+// сами элементы никогда не перемещаются и не копируются.
+template <class T>
+class Deque {
+  public:
+    Deque();
+    ~Deque();
+
+    Deque(const Deque&) = delete;
+    Deque& operator=(const Deque&) = delete;
+
+    // Проверка дека на пустоту
+    bool empty() const;
+    size_t size() const;
+    // Добавление элемента
+    template <class... Args>
+    void emplace_front(Args&&... args);
+    template <class... Args>
+    void emplace_back(Args&&... args);
+    void push_front(T value);
+    void push_back(T value);
+    // Извлечение
+    T pop_front();
+    T pop_back();
+
+  private:
+    // Элементов в блоке, степень двойки
+    static constexpr size_t kChunkShift = 6;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkShift;
+    static constexpr size_t kChunkMask = kChunkSize - 1;
+
+    // Карта блоков, ее размер тоже степень двойки
+    T** map = nullptr;
+    size_t map_size = 0;
+    // Позиции первого элемента и следующего за последним,
+    // считаются от начала первого блока карты
+    size_t first = 0;
+    size_t last = 0;
+    // Последний освободившийся блок, чтобы не выделять его заново
+    T* spare_chunk = nullptr;
+
+    // Адрес ячейки по позиции, блок выделяется при первом обращении
+    T* slot(size_t position);
+    // Освобождение блока, из которого ушли все элементы
+    void release_chunk(size_t chunk_index);
+    // Занятые блоки переносятся в середину карты,
+    // карта удваивается, только если занята больше чем наполовину
+    void grow_map();
+};
+
+template <class T>
+Deque<T>::Deque() {
+  map_size = 8;
+  map = new T*[map_size]();
+  first = last = (map_size / 2) << kChunkShift;
+}
+
+template <class T>
+Deque<T>::~Deque() {
+  while (!empty()) {
+    pop_back();
+  }
+  for (size_t i = 0; i < map_size; i++) {
+    ::operator delete(map[i]);
+  }
+  ::operator delete(spare_chunk);
+  delete[] map;
+}
+
+template <class T>
+bool Deque<T>::empty() const {
+  return first == last;
+}
+
+template <class T>
+size_t Deque<T>::size() const {
+  return last - first;
+}
+
+template <class T>
+T* Deque<T>::slot(size_t position) {
+  T*& chunk = map[position >> kChunkShift];
+  if (chunk == nullptr) {
+    if (spare_chunk != nullptr) {
+      chunk = spare_chunk;
+      spare_chunk = nullptr;
+    } else {
+      chunk = static_cast<T*>(::operator new(sizeof(T) * kChunkSize));
+    }
+  }
+  return chunk + (position & kChunkMask);
+}
+
+template <class T>
+void Deque<T>::release_chunk(size_t chunk_index) {
+  T*& chunk = map[chunk_index];
+  if (spare_chunk == nullptr) {
+    spare_chunk = chunk;
+  } else {
+    ::operator delete(chunk);
+  }
+  chunk = nullptr;
+}
+
+template <class T>
+template <class... Args>
+void Deque<T>::emplace_front(Args&&... args) {
+  // Если слева от первого элемента нет места, увеличиваем карту
+  if (first == 0) {
+    grow_map();
+  }
+  new (slot(first - 1)) T(std::forward<Args>(args)...);
+  first--;
+}
+
+template <class T>
+template <class... Args>
+void Deque<T>::emplace_back(Args&&... args) {
+  // Если справа нет места, увеличиваем карту
+  if (last == map_size << kChunkShift) {
+    grow_map();
+  }
+  new (slot(last)) T(std::forward<Args>(args)...);
+  last++;
+}
+
+template <class T>
+void Deque<T>::push_front(T value) {
+  emplace_front(std::move(value));
+}
+
+template <class T>
+void Deque<T>::push_back(T value) {
+  emplace_back(std::move(value));
+}
+
+template <class T>
+T Deque<T>::pop_front() {
+  // Проверка на пустоту
+  assert(!empty());
+  T* element = slot(first);
+  T result = std::move(*element);
+  element->~T();
+  first++;
+  // Первый элемент ушел из блока, блок больше не нужен
+  if ((first & kChunkMask) == 0) {
+    release_chunk((first - 1) >> kChunkShift);
+  }
+  return result;
+}
+
+template <class T>
+T Deque<T>::pop_back() {
+  // Проверка на пустоту
+  assert(!empty());
+  T* element = slot(last - 1);
+  T result = std::move(*element);
+  element->~T();
+  last--;
+  // Извлекли первый элемент блока, в нем больше ничего нет
+  if ((last & kChunkMask) == 0) {
+    release_chunk(last >> kChunkShift);
+  }
+  return result;
+}
+
+template <class T>
+void Deque<T>::grow_map() {
+  // Блоки, в которых лежат элементы (пустой дек занимает один блок)
+  size_t first_chunk = first >> kChunkShift;
+  size_t last_chunk = empty() ? first_chunk : (last - 1) >> kChunkShift;
+  size_t used_chunks = last_chunk - first_chunk + 1;
+  // Если карта занята не больше чем наполовину, достаточно
+  // перенести блоки в середину. Иначе карта удваивается,
+  // чтобы с обеих сторон хватило места
+  size_t new_map_size = map_size;
+  while (new_map_size < used_chunks * 2) {
+    new_map_size *= 2;
+  }
+  T** new_map = new T*[new_map_size]();
+  size_t new_first_chunk = (new_map_size - used_chunks) / 2;
+  // Переносим указатели на занятые блоки, свободные блоки освобождаем
+  for (size_t i = 0; i < map_size; i++) {
+    if (i >= first_chunk && i <= last_chunk) {
+      new_map[new_first_chunk + i - first_chunk] = map[i];
+    } else {
+      ::operator delete(map[i]);
+    }
+  }
+  size_t count = size();
+  first = (first - (first_chunk << kChunkShift)) +
+          (new_first_chunk << kChunkShift);
+  last = first + count;
+  delete[] map;
+  map = new_map;
+  map_size = new_map_size;
+}
+
+// Размер кэш-линии, чтобы счетчики разных потоков не делили одну линию
+constexpr size_t kCacheLineSize = 64;
+
+// Очередь на кольцевом буфере фиксированного размера
+// для одного потока-писателя и одного потока-читателя без блокировок.
+// Контракт push/pop/empty такой же, как у Queue:
+// push ждет свободного места, pop вызывается только для непустой очереди.
+class SpscQueue {
+  public:
+    // Размер буфера округляется вверх до степени двойки
+    explicit SpscQueue(size_t capacity);
+    ~SpscQueue();
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Проверка очереди на пустоту (со стороны читателя)
+    bool empty() const;
+    // Добавление элемента (только поток-писатель)
+    void push(int value);
+    bool try_push(int value);
+    // Извлечение (только поток-читатель)
+    int pop();
+    bool try_pop(int* value);
+
+  private:
+    size_t mask = 0;
+    int* buffer = nullptr;
+    // Индекс следующей записи, меняет только писатель.
+    // Рядом лежит закэшированная копия head, чтобы реже читать чужую линию.
+    alignas(kCacheLineSize) std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+    // Индекс следующего чтения, меняет только читатель,
+    // рядом закэшированная копия tail
+    alignas(kCacheLineSize) std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+};
+
+SpscQueue::SpscQueue(size_t capacity) {
+  size_t size = 2;
+  while (size < capacity) {
+    size *= 2;
+  }
+  mask = size - 1;
+  buffer = new int[size];
+}
+
+SpscQueue::~SpscQueue() {
+  delete[] buffer;
+}
+
+bool SpscQueue::empty() const {
+  return head.load(std::memory_order_relaxed) ==
+         tail.load(std::memory_order_acquire);
+}
+
+bool SpscQueue::try_push(int value) {
+  size_t current_tail = tail.load(std::memory_order_relaxed);
+  // Сначала сверяемся с закэшированным head и только если буфер
+  // кажется полным, перечитываем настоящий
+  if (current_tail - cached_head > mask) {
+    cached_head = head.load(std::memory_order_acquire);
+    if (current_tail - cached_head > mask) {
+      return false;
+    }
+  }
+  buffer[current_tail & mask] = value;
+  // release публикует записанный элемент для читателя
+  tail.store(current_tail + 1, std::memory_order_release);
+  return true;
+}
+
+void SpscQueue::push(int value) {
+  // Буфер не растет, поэтому ждем, пока читатель освободит место
+  while (!try_push(value)) {
+    std::this_thread::yield();
+  }
+}
+
+bool SpscQueue::try_pop(int* value) {
+  size_t current_head = head.load(std::memory_order_relaxed);
+  if (current_head == cached_tail) {
+    cached_tail = tail.load(std::memory_order_acquire);
+    if (current_head == cached_tail) {
+      return false;
+    }
+  }
+  *value = buffer[current_head & mask];
+  // release отдает ячейку писателю только после чтения
+  head.store(current_head + 1, std::memory_order_release);
+  return true;
+}
+
+int SpscQueue::pop() {
+  // Проверка на пустоту
+  assert(!empty());
+  int result = 0;
+  bool popped = try_pop(&result);
+  assert(popped);
+  (void)popped;
+  return result;
+}
+
+// Ограниченная очередь на кольцевом буфере для нескольких писателей
+// и нескольких читателей (схема Вьюкова с номером последовательности
+// в каждой ячейке). Неблокирующие try_push/try_pop и блокирующие
+// push/pop, которые сначала крутятся, а потом засыпают.
+class MpmcQueue {
+  public:
+    // Размер буфера округляется вверх до степени двойки
+    explicit MpmcQueue(size_t capacity);
+    ~MpmcQueue();
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // Добавление, false если очередь полна
+    bool try_push(int value);
+    // Извлечение, false если очередь пуста
+    bool try_pop(int* value);
+    // Добавление с ожиданием свободного места
+    void push(int value);
+    // Извлечение с ожиданием элемента
+    int pop();
+
+  private:
+    // Сколько раз пробуем без засыпания
+    static constexpr int kSpinCount = 256;
+
+    struct Cell {
+      // Номер позиции, для которой ячейка готова:
+      // pos - можно писать, pos + 1 - можно читать
+      std::atomic<size_t> sequence;
+      int value;
+    };
+
+    bool push_once(int value);
+    bool pop_once(int* value);
+    // Будит уснувшие потоки, если такие есть
+    void wake();
+
+    size_t mask = 0;
+    Cell* cells = nullptr;
+    alignas(kCacheLineSize) std::atomic<size_t> enqueue_pos{0};
+    alignas(kCacheLineSize) std::atomic<size_t> dequeue_pos{0};
+    // Количество уснувших потоков и все для их парковки
+    alignas(kCacheLineSize) std::atomic<int> waiters{0};
+    std::mutex park_mutex;
+    std::condition_variable state_changed;
+};
+
+MpmcQueue::MpmcQueue(size_t capacity) {
+  size_t size = 2;
+  while (size < capacity) {
+    size *= 2;
+  }
+  mask = size - 1;
+  cells = new Cell[size];
+  for (size_t i = 0; i < size; i++) {
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+MpmcQueue::~MpmcQueue() {
+  delete[] cells;
+}
+
+bool MpmcQueue::push_once(int value) {
+  size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+  Cell* cell = nullptr;
+  while (true) {
+    cell = &cells[pos & mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(sequence) -
+                    static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      // Ячейка свободна, пробуем занять позицию
+      if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Ячейку еще не прочитали с прошлого круга - очередь полна
+      return false;
+    } else {
+      // Другой писатель успел раньше, берем свежую позицию
+      pos = enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+  cell->value = value;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool MpmcQueue::pop_once(int* value) {
+  size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+  Cell* cell = nullptr;
+  while (true) {
+    cell = &cells[pos & mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(sequence) -
+                    static_cast<intptr_t>(pos + 1);
+    if (diff == 0) {
+      if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // В ячейку еще не записали - очередь пуста
+      return false;
+    } else {
+      pos = dequeue_pos.load(std::memory_order_relaxed);
+    }
+  }
+  *value = cell->value;
+  // Освобождаем ячейку для следующего круга
+  cell->sequence.store(pos + mask + 1, std::memory_order_release);
+  return true;
+}
+
+void MpmcQueue::wake() {
+  // Барьер в паре с барьером в push/pop: либо мы увидим счетчик
+  // уснувших, либо уснувший поток увидит наше изменение ячейки
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(park_mutex);
+    state_changed.notify_all();
+  }
+}
+
+bool MpmcQueue::try_push(int value) {
+  if (!push_once(value)) {
+    return false;
+  }
+  wake();
+  return true;
+}
+
+bool MpmcQueue::try_pop(int* value) {
+  if (!pop_once(value)) {
+    return false;
+  }
+  wake();
+  return true;
+}
+
+void MpmcQueue::push(int value) {
+  for (int spin = 0; spin < kSpinCount; spin++) {
+    if (try_push(value)) {
+      return;
+    }
+  }
+  // Не дождались - засыпаем, пока кто-нибудь не освободит ячейку
+  std::unique_lock<std::mutex> lock(park_mutex);
+  waiters.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (!push_once(value)) {
+    state_changed.wait(lock);
+  }
+  waiters.fetch_sub(1);
+  lock.unlock();
+  wake();
+}
+
+int MpmcQueue::pop() {
+  int result = 0;
+  for (int spin = 0; spin < kSpinCount; spin++) {
+    if (try_pop(&result)) {
+      return result;
+    }
+  }
+  // Не дождались - засыпаем, пока кто-нибудь не добавит элемент
+  std::unique_lock<std::mutex> lock(park_mutex);
+  waiters.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (!pop_once(&result)) {
+    state_changed.wait(lock);
+  }
+  waiters.fetch_sub(1);
+  lock.unlock();
+  wake();
+  return result;
+}
+
+// Возвращает индекс первого несовпадения actual и expected
+// или n, если все n значений совпали
+int find_mismatch(const int* actual, const int* expected, int n) {
+  int i = 0;
+#ifdef __SSE2__
+  // Сравниваем по 4 числа за раз
+  for (; i + 4 <= n; i += 4) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(actual + i));
+    __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(expected + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) != 0xFFFF) {
+      break;
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    if (actual[i] != expected[i]) {
+      return i;
+    }
+  }
+  return n;
+}
+
+// Проверка команд для дека по одной
+bool check_deque_commands(const int* commands, const int* values, int n) {
+  Deque<int> deque;
+  for (int i = 0; i < n; ++i) {
+    int command = commands[i];
+    int value = values[i];
+    if (command == 1) {
+      deque.push_front(value);
+    } else if (command == 3) {
+      deque.push_back(value);
+    } else if (command == 2 || command == 4) {
+      // Проверка на пустоту, чтобы не вызывать pop для пустого дека
+      if (deque.empty()) {
+        // Если дек пуст и должны вернуть не -1, проверка не прошла
         if (value != -1) {
-          // Если очередь пуста и должны вернуть не -1, флаг будет false
-          expected_value_flag = false;
-          break;
+          return false;
+        }
+      } else {
+        int popped = (command == 2) ? deque.pop_front() : deque.pop_back();
+        if (popped != value) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Проверка команд для очереди пачками: подряд идущие команды 3
+// добавляются одним push_n, подряд идущие команды 2 извлекаются
+// одним pop_n и сверяются с ожидаемыми значениями за один проход
+bool check_queue_commands(const int* commands, const int* values, int n) {
+  Queue queue;
+  std::vector<int> popped;
+  int i = 0;
+  while (i < n) {
+    // Ищем конец серии одинаковых команд
+    int j = i;
+    while (j < n && commands[j] == commands[i]) {
+      j++;
+    }
+    int run_length = j - i;
+    if (commands[i] == 3) {
+      queue.push_n(values + i, run_length);
+    } else if (commands[i] == 2) {
+      int available = std::min(run_length, queue.count());
+      popped.resize(available);
+      queue.pop_n(popped.data(), available);
+      if (find_mismatch(popped.data(), values + i, available) != available) {
+        return false;
+      }
+      // Остальные pop приходятся на пустую очередь и должны ждать -1
+      for (int k = i + available; k < j; k++) {
+        if (values[k] != -1) {
+          return false;
         }
-      } else if (queue.pop() != value) {
-        // Если очередь не пуста
-        // и значение не совпадет с ожидаемым, флаг будет false
-        expected_value_flag = false;
-        break;
       }
     }
+    i = j;
+  }
+  return true;
+}
+
+int main() {
+  int commands_count = 0;
+  std::cin >> commands_count;
+  std::vector<int> commands(commands_count);
+  std::vector<int> values(commands_count);
+  // Для очереди используются только команды 2 и 3
+  bool queue_commands_only = true;
+  for (int i = 0; i < commands_count; ++i) {
+    std::cin >> commands[i] >> values[i];
+    if (commands[i] == 1 || commands[i] == 4) {
+      queue_commands_only = false;
+    }
   }
+  // Флаг будет равен true, если все ожидаемые значения совпадут
+  bool expected_value_flag = queue_commands_only
+      ? check_queue_commands(commands.data(), values.data(), commands_count)
+      : check_deque_commands(commands.data(), values.data(), commands_count);
   if (expected_value_flag) {
       std::cout << "YES";
   } else {
@@ -13,8 +13,32 @@ Out:
 0 1 2 3 4 5 6 7 8 9
 */
 #include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MERGE_HAVE_AVX2 1
+#endif
 
 void Merge(int* first_arr, int firstLen, int* second_arr, int secondLen,
            int *c, bool (*compare)(int first, int second)) {
@@ -34,6 +58,124 @@ void Merge(int* first_arr, int firstLen, int* second_arr, int secondLen,
     }
 }
 
+// Слияние отсортированных массивов int без компаратора
+void MergeIntsScalar(const int* first_arr, int firstLen,
+                     const int* second_arr, int secondLen, int* c) {
+    int i = 0;
+    int j = 0;
+    while (i < firstLen && j < secondLen) {
+        if (second_arr[j] < first_arr[i]) {
+            *c++ = second_arr[j++];
+        } else {
+            *c++ = first_arr[i++];
+        }
+    }
+    // Остаток одного из массивов переносим целиком
+    memcpy(c, first_arr + i, sizeof(int) * (firstLen - i));
+    c += firstLen - i;
+    memcpy(c, second_arr + j, sizeof(int) * (secondLen - j));
+}
+
+#ifdef MERGE_HAVE_AVX2
+// Сортирует битоническую последовательность из 8 чисел
+// сетью сравнений на расстояниях 4, 2 и 1
+__attribute__((target("avx2")))
+static inline __m256i BitonicSort8(__m256i v) {
+    __m256i swapped = _mm256_permute2x128_si256(v, v, 1);
+    v = _mm256_blend_epi32(_mm256_min_epi32(v, swapped),
+                           _mm256_max_epi32(v, swapped), 0xF0);
+    swapped = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    v = _mm256_blend_epi32(_mm256_min_epi32(v, swapped),
+                           _mm256_max_epi32(v, swapped), 0xCC);
+    swapped = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm256_blend_epi32(_mm256_min_epi32(v, swapped),
+                           _mm256_max_epi32(v, swapped), 0xAA);
+    return v;
+}
+
+// Сливает два отсортированных вектора по 8 чисел:
+// в low попадают 8 наименьших, в high - 8 наибольших
+__attribute__((target("avx2")))
+static inline void BitonicMerge8(__m256i a, __m256i b,
+                                 __m256i* low, __m256i* high) {
+    // a по возрастанию и развернутый b вместе образуют битоническую
+    // последовательность, min и max по парам делят ее на две половины
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    b = _mm256_permutevar8x32_epi32(b, reverse);
+    *low = BitonicSort8(_mm256_min_epi32(a, b));
+    *high = BitonicSort8(_mm256_max_epi32(a, b));
+}
+
+__attribute__((target("avx2")))
+void MergeIntsAvx2(const int* first_arr, int firstLen,
+                   const int* second_arr, int secondLen, int* c) {
+    if (firstLen < 8 || secondLen < 8) {
+        MergeIntsScalar(first_arr, firstLen, second_arr, secondLen, c);
+        return;
+    }
+    __m256i low;
+    __m256i high =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second_arr));
+    __m256i next =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first_arr));
+    int i = 8;
+    int j = 8;
+    while (true) {
+        BitonicMerge8(next, high, &low, &high);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c), low);
+        c += 8;
+        // Следующие 8 чисел берем из массива с меньшим первым элементом,
+        // все выведенные не больше любого из оставшихся
+        const int* source = nullptr;
+        if (i < firstLen && (j == secondLen || first_arr[i] <= second_arr[j])) {
+            if (i + 8 > firstLen) {
+                break;
+            }
+            source = first_arr + i;
+            i += 8;
+        } else if (j < secondLen) {
+            if (j + 8 > secondLen) {
+                break;
+            }
+            source = second_arr + j;
+            j += 8;
+        } else {
+            break;
+        }
+        next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+    }
+    // Остались 8 чисел в high и хвосты массивов, из которых
+    // хотя бы один короче 8: сливаем high с коротким, затем с длинным
+    int high_values[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(high_values), high);
+    const int* short_arr = first_arr + i;
+    int shortLen = firstLen - i;
+    const int* long_arr = second_arr + j;
+    int longLen = secondLen - j;
+    if (shortLen > longLen) {
+        std::swap(short_arr, long_arr);
+        std::swap(shortLen, longLen);
+    }
+    int head[16];
+    MergeIntsScalar(high_values, 8, short_arr, shortLen, head);
+    MergeIntsScalar(head, 8 + shortLen, long_arr, longLen, c);
+}
+#endif
+
+// Слияние отсортированных по возрастанию массивов int.
+// На процессорах с AVX2 сливает векторами по 8 чисел.
+void MergeInts(const int* first_arr, int firstLen,
+               const int* second_arr, int secondLen, int* c) {
+#ifdef MERGE_HAVE_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+        MergeIntsAvx2(first_arr, firstLen, second_arr, secondLen, c);
+        return;
+    }
+#endif
+    MergeIntsScalar(first_arr, firstLen, second_arr, secondLen, c);
+}
+
 void MergeSort(int* a, int aLen, bool (*compare)(int first, int second)) {
     if (aLen <= 1) {
         return;
@@ -52,58 +194,908 @@ bool CompareLess(int first, int second) {
   return first < second;
 }
 
+// Сортировка слиянием без выделения памяти,
+// buffer должен вмещать не меньше aLen элементов
+void MergeSortWithBuffer(int* a, int aLen, int* buffer,
+                         bool (*compare)(int first, int second)) {
+    if (aLen <= 1) {
+        return;
+    }
+    int firstLen = aLen / 2;
+    int secondLen = aLen - firstLen;
+    MergeSortWithBuffer(a, firstLen, buffer, compare);
+    MergeSortWithBuffer(a + firstLen, secondLen, buffer, compare);
+    // Для обычного порядка int есть векторное слияние
+    if (compare == CompareLess) {
+        MergeInts(a, firstLen, a + firstLen, secondLen, buffer);
+    } else {
+        Merge(a, firstLen, a + firstLen, secondLen, buffer, compare);
+    }
+    memcpy(a, buffer, sizeof(int) * aLen);
+}
 
+// Пул потоков с воровством задач. У каждого потока своя очередь:
+// свои задачи он берет с конца, чужие ворует с начала.
+class TaskPool {
+ public:
+    explicit TaskPool(int threads_count);
+    ~TaskPool();
 
-int main() {
-    int n = 0;
-    int k = 0;
-    std::cin >> n >> k;
-    int* arr = new int[k * 2];
-    // Если количество элементов меньше или равно 2k, то считываем, сортируем
-    // и выводим все сразу
-    if (n <= k * 2) {
-        for (int i = 0; i < n; i++) {
-            std::cin >> arr[i];
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    int ThreadsCount() const;
+
+    // Группа задач, завершения которых можно дождаться.
+    // Ожидающий поток не простаивает, а выполняет задачи из пула.
+    class TaskGroup {
+     public:
+        explicit TaskGroup(TaskPool* _pool) : pool(_pool) {}
+        ~TaskGroup();
+
+        void Run(std::function<void()> task);
+        void Wait();
+
+     private:
+        TaskPool* pool = nullptr;
+        std::atomic<int> pending{0};
+    };
+
+ private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void Submit(std::function<void()> task);
+    // Выполняет одну задачу: свою, если есть, иначе украденную
+    bool TryRunOne();
+    void WorkerLoop(int index);
+    // Пул, которому принадлежит текущий поток, и номер его очереди.
+    // У внешних потоков пул не задан
+    struct CurrentWorker {
+        const TaskPool* pool = nullptr;
+        int index = 0;
+    };
+    static CurrentWorker& Current();
+    // Номер очереди текущего потока в этом пуле. Потоки других пулов
+    // для нас внешние и работают с очередью 0
+    int CurrentIndex() const;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopping{false};
+    std::atomic<int> queued{0};
+    std::mutex sleep_mutex;
+    std::condition_variable has_tasks;
+};
+
+TaskPool::TaskPool(int threads_count) {
+    assert(threads_count > 0);
+    // Очередь 0 принадлежит внешним потокам, остальные - потокам пула
+    for (int i = 0; i < threads_count; i++) {
+        workers.emplace_back(new Worker());
+    }
+    for (int i = 1; i < threads_count; i++) {
+        threads.emplace_back(&TaskPool::WorkerLoop, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        has_tasks.notify_all();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+int TaskPool::ThreadsCount() const {
+    return static_cast<int>(workers.size());
+}
+
+TaskPool::CurrentWorker& TaskPool::Current() {
+    static thread_local CurrentWorker current;
+    return current;
+}
+
+int TaskPool::CurrentIndex() const {
+    const CurrentWorker& current = Current();
+    return current.pool == this ? current.index : 0;
+}
+
+void TaskPool::Submit(std::function<void()> task) {
+    int index = CurrentIndex();
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    queued++;
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    has_tasks.notify_one();
+}
+
+bool TaskPool::TryRunOne() {
+    int self = CurrentIndex();
+    int count = ThreadsCount();
+    std::function<void()> task;
+    // Сначала своя очередь с конца, затем чужие с начала
+    for (int shift = 0; shift < count && !task; shift++) {
+        Worker& worker = *workers[(self + shift) % count];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) {
+            continue;
         }
-        MergeSort(arr, n, CompareLess);
-        for (int i = 0; i < n; i++) {
-            std::cout << arr[i] << " ";
+        if (shift == 0) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        } else {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
         }
+    }
+    if (!task) {
+        return false;
+    }
+    queued--;
+    task();
+    return true;
+}
 
-    // Если элементов больше 2k, то считываем, сортируем и выводим по частям
+void TaskPool::WorkerLoop(int index) {
+    Current().pool = this;
+    Current().index = index;
+    while (!stopping) {
+        if (TryRunOne()) {
+            continue;
+        }
+        // Задач нет - засыпаем. Ожидание с таймаутом страхует
+        // от пропущенного уведомления между проверкой и засыпанием.
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        has_tasks.wait_for(lock, std::chrono::milliseconds(1), [this] {
+            return stopping || queued > 0;
+        });
+    }
+}
+
+TaskPool::TaskGroup::~TaskGroup() {
+    Wait();
+}
+
+void TaskPool::TaskGroup::Run(std::function<void()> task) {
+    pending++;
+    pool->Submit([this, task = std::move(task)] {
+        task();
+        pending--;
+    });
+}
+
+void TaskPool::TaskGroup::Wait() {
+    while (pending > 0) {
+        if (!pool->TryRunOne()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Общий пул на все ядра
+TaskPool& SharedTaskPool() {
+    static TaskPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+// Меньше этого размера части сортируются и сливаются в текущем потоке
+const std::ptrdiff_t kParallelSortCutoff = 1 << 13;
+const std::ptrdiff_t kParallelMergeCutoff = 1 << 14;
+// Меньше этого размера сортируем вставками
+const std::ptrdiff_t kInsertionSortCutoff = 24;
+
+// Слияние [first1, last1) и [first2, last2) в out.
+// Большие слияния делятся пополам: середина большего куска ищется
+// бинарным поиском в меньшем, и две половины сливаются параллельно.
+template <class In1, class In2, class Out, class Cmp>
+void ParallelMerge(In1 first1, In1 last1, In2 first2, In2 last2, Out out,
+                   Cmp compare, TaskPool* pool) {
+    std::ptrdiff_t len1 = last1 - first1;
+    std::ptrdiff_t len2 = last2 - first2;
+    if (len1 + len2 <= kParallelMergeCutoff || pool->ThreadsCount() == 1) {
+        std::merge(std::make_move_iterator(first1),
+                   std::make_move_iterator(last1),
+                   std::make_move_iterator(first2),
+                   std::make_move_iterator(last2), out, compare);
+        return;
+    }
+    In1 middle1;
+    In2 middle2;
+    // Для устойчивости равные элементы первого куска идут раньше второго
+    if (len1 >= len2) {
+        middle1 = first1 + len1 / 2;
+        middle2 = std::lower_bound(first2, last2, *middle1, compare);
     } else {
-        // Сначала считываем 2k чисел
-        for (int i = 0; i < k * 2; i++) {
-            std::cin >> arr[i];
-        }
-        MergeSort(arr, k * 2, CompareLess);
-        // Выводим k отсортированных чисел
-        // и запоминаем, что k у нас остается в массиве
-        for (int i = 0; i < k; i++) {
-            std::cout << arr[i] << " ";
-        }
-        // В цикле читаем и выводим по k чисел, при этом сортируем 2k чисел
-        // Повторяем (n/k)-2 раз, т.к. 2k чисел считали в начале.
-        for (int j = 0; j < (n / k) - 2; j++) {
-            for (int i = 0; i < k; i++) {
-                std::cin >> arr[i];
+        middle2 = first2 + len2 / 2;
+        middle1 = std::upper_bound(first1, last1, *middle2, compare);
+    }
+    Out middle_out = out + (middle1 - first1) + (middle2 - first2);
+    TaskPool::TaskGroup group(pool);
+    group.Run([=] {
+        ParallelMerge(first1, middle1, first2, middle2, out, compare, pool);
+    });
+    ParallelMerge(middle1, last1, middle2, last2, middle_out, compare, pool);
+    group.Wait();
+}
+
+// Сортирует n элементов, лежащих в a. Результат попадает в b,
+// если result_in_b, иначе остается в a; второй массив служит буфером.
+// Уровни рекурсии чередуют направление, поэтому обратного копирования нет.
+template <class A, class B, class Cmp>
+void ParallelMergeSortImpl(A a, B b, std::ptrdiff_t n, bool result_in_b,
+                           Cmp compare, TaskPool* pool) {
+    if (n <= kInsertionSortCutoff) {
+        // Устойчивая сортировка вставками на месте
+        for (std::ptrdiff_t i = 1; i < n; i++) {
+            auto value = std::move(a[i]);
+            std::ptrdiff_t j = i;
+            for (; j > 0 && compare(value, a[j - 1]); j--) {
+                a[j] = std::move(a[j - 1]);
             }
-            MergeSort(arr, k * 2, CompareLess);
-            for (int i = 0; i < k; i++) {
-                std::cout << arr[i] << " ";
+            a[j] = std::move(value);
+        }
+        if (result_in_b) {
+            std::move(a, a + n, b);
+        }
+        return;
+    }
+    std::ptrdiff_t half = n / 2;
+    // Половины сортируем туда, откуда их будем сливать
+    if (n > kParallelSortCutoff && pool->ThreadsCount() > 1) {
+        TaskPool::TaskGroup group(pool);
+        group.Run([=] {
+            ParallelMergeSortImpl(a, b, half, !result_in_b, compare, pool);
+        });
+        ParallelMergeSortImpl(a + half, b + half, n - half, !result_in_b,
+                              compare, pool);
+        group.Wait();
+    } else {
+        ParallelMergeSortImpl(a, b, half, !result_in_b, compare, pool);
+        ParallelMergeSortImpl(a + half, b + half, n - half, !result_in_b,
+                              compare, pool);
+    }
+    if (result_in_b) {
+        ParallelMerge(a, a + half, a + half, a + n, b, compare, pool);
+    } else {
+        ParallelMerge(b, b + half, b + half, b + n, a, compare, pool);
+    }
+}
+
+// Устойчивая параллельная сортировка слиянием
+// с произвольным компаратором-функтором
+template <class It, class Cmp>
+void ParallelMergeSort(It first, It last, Cmp compare, TaskPool* pool) {
+    using Value = typename std::iterator_traits<It>::value_type;
+    std::ptrdiff_t n = last - first;
+    if (n <= 1) {
+        return;
+    }
+    std::vector<Value> buffer(n);
+    ParallelMergeSortImpl(first, buffer.begin(), n, false, compare, pool);
+}
+
+template <class It, class Cmp>
+void ParallelMergeSort(It first, It last, Cmp compare) {
+    ParallelMergeSort(first, last, compare, &SharedTaskPool());
+}
+
+// Буферизированный вывод чисел через fwrite
+class BufferedWriter {
+ public:
+    explicit BufferedWriter(FILE* _out) : out(_out) {}
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    // Выводит число и пробел после него
+    void WriteInt(int value);
+    void Flush();
+
+ private:
+    static const int kBufferSize = 1 << 16;
+    // Самое длинное число с пробелом: "-2147483648 "
+    static const int kMaxIntLength = 12;
+
+    FILE* out = nullptr;
+    char buffer[kBufferSize];
+    int used = 0;
+};
+
+BufferedWriter::~BufferedWriter() {
+    Flush();
+}
+
+void BufferedWriter::WriteInt(int value) {
+    if (used + kMaxIntLength > kBufferSize) {
+        Flush();
+    }
+    // Цифры получаются с конца, поэтому собираем их во временном массиве
+    char digits[kMaxIntLength];
+    int length = 0;
+    unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value)
+                                       : static_cast<unsigned int>(value);
+    do {
+        digits[length++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        buffer[used++] = '-';
+    }
+    while (length > 0) {
+        buffer[used++] = digits[--length];
+    }
+    buffer[used++] = ' ';
+}
+
+void BufferedWriter::Flush() {
+    if (used > 0) {
+        fwrite(buffer, 1, used, out);
+        used = 0;
+    }
+    fflush(out);
+}
+
+// Потоковая сортировка почти упорядоченной последовательности.
+// Держит в памяти k уже отсортированных чисел и очередную порцию из k новых.
+// Новая порция сортируется и сливается с удержанными числами,
+// k наименьших из них выводятся. Вся память выделяется один раз.
+// Writer - любой приемник с методами WriteInt и Flush.
+template <class Writer>
+class KSortedStreamSorter {
+ public:
+    KSortedStreamSorter(int _k, Writer* _writer);
+    ~KSortedStreamSorter();
+
+    KSortedStreamSorter(const KSortedStreamSorter&) = delete;
+    KSortedStreamSorter& operator=(const KSortedStreamSorter&) = delete;
+
+    // Удалось ли выделить окно
+    bool Allocated() const { return window != nullptr; }
+    // Добавляет очередное число последовательности
+    void Push(int value);
+    // Выводит все оставшиеся числа
+    void Finish();
+
+ private:
+    // Сортирует новую порцию, сливает с удержанными числами
+    // и выводит все, кроме k наибольших
+    void ProcessChunk();
+
+    int k = 0;
+    Writer* writer = nullptr;
+    // Окно из 2k чисел: сначала удержанные, за ними новая порция
+    int* window = nullptr;
+    // Буфер на 2k чисел для слияний
+    int* scratch = nullptr;
+    // Каждый из счетчиков не больше k, но их сумма может не влезть в int
+    size_t retained_count = 0;
+    size_t chunk_count = 0;
+};
+
+template <class Writer>
+KSortedStreamSorter<Writer>::KSortedStreamSorter(int _k, Writer* _writer)
+    : k(_k), writer(_writer) {
+    assert(k > 0);
+    // Окно и буфер одним выделением. При нехватке памяти окно
+    // остается пустым, это проверяет вызывающий через Allocated
+    size_t window_size = static_cast<size_t>(k) * 2;
+    window = new (std::nothrow) int[window_size * 2];
+    scratch = window ? window + window_size : nullptr;
+}
+
+template <class Writer>
+KSortedStreamSorter<Writer>::~KSortedStreamSorter() {
+    delete[] window;
+}
+
+template <class Writer>
+void KSortedStreamSorter<Writer>::Push(int value) {
+    window[retained_count + chunk_count] = value;
+    chunk_count++;
+    if (chunk_count == static_cast<size_t>(k)) {
+        ProcessChunk();
+    }
+}
+
+template <class Writer>
+void KSortedStreamSorter<Writer>::ProcessChunk() {
+    int* chunk = window + retained_count;
+    MergeSortWithBuffer(chunk, static_cast<int>(chunk_count), scratch,
+                        CompareLess);
+    size_t total = retained_count + chunk_count;
+    MergeInts(window, static_cast<int>(retained_count), chunk,
+              static_cast<int>(chunk_count), scratch);
+    // Любое следующее число не меньше любого из k наименьших в окне,
+    // поэтому их можно выводить, а k наибольших остаются ждать
+    size_t window_k = static_cast<size_t>(k);
+    size_t output_count = total > window_k ? total - window_k : 0;
+    for (size_t i = 0; i < output_count; i++) {
+        writer->WriteInt(scratch[i]);
+    }
+    retained_count = total - output_count;
+    memcpy(window, scratch + output_count, sizeof(int) * retained_count);
+    chunk_count = 0;
+}
+
+template <class Writer>
+void KSortedStreamSorter<Writer>::Finish() {
+    if (chunk_count > 0) {
+        ProcessChunk();
+    }
+    for (size_t i = 0; i < retained_count; i++) {
+        writer->WriteInt(window[i]);
+    }
+    retained_count = 0;
+    writer->Flush();
+}
+
+
+
+// Выравнивание и минимальный размер блоков ввода-вывода
+const size_t kIoAlignment = 4096;
+
+// Учет памяти внешней сортировки, не дает превысить лимит
+class MemoryBudget {
+ public:
+    explicit MemoryBudget(size_t _limit) : limit(_limit) {}
+
+    // Выделяет выровненный буфер, nullptr если лимит будет превышен
+    void* Allocate(size_t bytes);
+    void Release(void* data, size_t bytes);
+    // Учитывает память, которую выделяет кто-то другой
+    bool Reserve(size_t bytes);
+    void Unreserve(size_t bytes);
+    size_t Available() const;
+
+ private:
+    size_t limit = 0;
+    size_t used = 0;
+};
+
+void* MemoryBudget::Allocate(size_t bytes) {
+    if (!Reserve(bytes)) {
+        return nullptr;
+    }
+    void* data = nullptr;
+    if (posix_memalign(&data, kIoAlignment, bytes) != 0) {
+        Unreserve(bytes);
+        return nullptr;
+    }
+    return data;
+}
+
+void MemoryBudget::Release(void* data, size_t bytes) {
+    free(data);
+    Unreserve(bytes);
+}
+
+bool MemoryBudget::Reserve(size_t bytes) {
+    if (bytes > Available()) {
+        return false;
+    }
+    used += bytes;
+    return true;
+}
+
+void MemoryBudget::Unreserve(size_t bytes) {
+    assert(bytes <= used);
+    used -= bytes;
+}
+
+size_t MemoryBudget::Available() const {
+    return limit - used;
+}
+
+// Чтение чисел из куска файла [offset, end) большими блоками
+class BlockReader {
+ public:
+    BlockReader(int _fd, off_t _offset, off_t _end, int* _buffer,
+                size_t _capacity)
+        : fd(_fd), offset(_offset), end(_end), buffer(_buffer),
+          capacity(_capacity) {}
+
+    // Следующее число, false в конце куска или при ошибке
+    bool Next(int* value);
+    bool Failed() const { return failed; }
+
+ private:
+    bool Fill();
+
+    int fd = -1;
+    off_t offset = 0;
+    off_t end = 0;
+    int* buffer = nullptr;
+    size_t capacity = 0;
+    size_t count = 0;
+    size_t position = 0;
+    bool failed = false;
+};
+
+bool BlockReader::Fill() {
+    size_t bytes = std::min<off_t>(capacity * sizeof(int), end - offset);
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t result = pread(fd, reinterpret_cast<char*>(buffer) + done,
+                               bytes - done, offset + done);
+        if (result <= 0) {
+            failed = true;
+            return false;
+        }
+        done += result;
+    }
+    offset += bytes;
+    count = bytes / sizeof(int);
+    position = 0;
+    return count > 0;
+}
+
+bool BlockReader::Next(int* value) {
+    if (position == count && !Fill()) {
+        return false;
+    }
+    *value = buffer[position++];
+    return true;
+}
+
+// Запись чисел в файл целыми выровненными блоками
+class BlockWriter {
+ public:
+    BlockWriter(int _fd, int* _buffer, size_t _capacity)
+        : fd(_fd), buffer(_buffer), capacity(_capacity) {}
+
+    void WriteInt(int value);
+    // Дописывает неполный последний блок
+    void Flush();
+    bool Failed() const { return failed; }
+
+ private:
+    int fd = -1;
+    int* buffer = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    bool failed = false;
+};
+
+void BlockWriter::WriteInt(int value) {
+    if (used == capacity) {
+        Flush();
+    }
+    buffer[used++] = value;
+}
+
+void BlockWriter::Flush() {
+    size_t bytes = used * sizeof(int);
+    size_t done = 0;
+    while (done < bytes && !failed) {
+        ssize_t result = write(fd, reinterpret_cast<char*>(buffer) + done,
+                               bytes - done);
+        if (result <= 0) {
+            failed = true;
+        } else {
+            done += result;
+        }
+    }
+    used = 0;
+}
+
+// Запись всего массива в файл
+bool WriteAll(int fd, const int* data, size_t count) {
+    const char* bytes = reinterpret_cast<const char*>(data);
+    size_t left = count * sizeof(int);
+    while (left > 0) {
+        ssize_t result = write(fd, bytes, left);
+        if (result <= 0) {
+            return false;
+        }
+        bytes += result;
+        left -= result;
+    }
+    return true;
+}
+
+// Чтение до count чисел, возвращает сколько прочитано или -1 при ошибке
+ssize_t ReadUpTo(int fd, int* data, size_t count) {
+    char* bytes = reinterpret_cast<char*>(data);
+    size_t want = count * sizeof(int);
+    size_t done = 0;
+    while (done < want) {
+        ssize_t result = read(fd, bytes + done, want - done);
+        if (result < 0) {
+            return -1;
+        }
+        if (result == 0) {
+            break;
+        }
+        done += result;
+    }
+    return done / sizeof(int);
+}
+
+// Безымянный временный файл рядом с выходным
+int OpenTemporaryFile(const char* directory) {
+    std::string path = std::string(directory) + "/ksort-run-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd != -1) {
+        unlink(path.c_str());
+    }
+    return fd;
+}
+
+// Отсортированный кусок во временном файле
+struct SortedRun {
+    off_t begin = 0;
+    off_t end = 0;
+};
+
+// Пары (значение, номер куска) в куче слияния
+typedef std::pair<int, size_t> MergeHeapEntry;
+// Память слияния на каждый кусок кроме блока: читатель,
+// указатель на его буфер и место в куче
+const size_t kMergeRunOverhead =
+    sizeof(BlockReader) + sizeof(int*) + sizeof(MergeHeapEntry);
+
+// Слияние нескольких отсортированных кусков через кучу
+bool MergeRuns(int input_fd, const SortedRun* runs, size_t runs_count,
+               BlockWriter* writer, MemoryBudget* budget, size_t block_ints) {
+    size_t block_bytes = block_ints * sizeof(int);
+    // Векторы читателей и кучи выделяются ровно под runs_count
+    // и не растут, поэтому их память известна заранее
+    size_t overhead_bytes = runs_count * kMergeRunOverhead;
+    if (!budget->Reserve(overhead_bytes)) {
+        return false;
+    }
+    std::vector<BlockReader> readers;
+    std::vector<int*> buffers;
+    std::vector<MergeHeapEntry> heap_storage;
+    readers.reserve(runs_count);
+    buffers.reserve(runs_count);
+    heap_storage.reserve(runs_count);
+    bool ok = true;
+    for (size_t i = 0; i < runs_count && ok; i++) {
+        int* buffer = static_cast<int*>(budget->Allocate(block_bytes));
+        if (!buffer) {
+            ok = false;
+            break;
+        }
+        buffers.push_back(buffer);
+        readers.emplace_back(input_fd, runs[i].begin, runs[i].end, buffer,
+                             block_ints);
+    }
+    if (ok) {
+        // Наверху минимальное значение
+        std::priority_queue<MergeHeapEntry, std::vector<MergeHeapEntry>,
+                            std::greater<MergeHeapEntry>>
+            heap(std::greater<MergeHeapEntry>(), std::move(heap_storage));
+        int value = 0;
+        for (size_t i = 0; i < readers.size(); i++) {
+            if (readers[i].Next(&value)) {
+                heap.emplace(value, i);
+            }
+        }
+        while (!heap.empty()) {
+            MergeHeapEntry top = heap.top();
+            heap.pop();
+            writer->WriteInt(top.first);
+            if (readers[top.second].Next(&value)) {
+                heap.emplace(value, top.second);
+            }
+        }
+        for (const BlockReader& reader : readers) {
+            ok = ok && !reader.Failed();
+        }
+    }
+    for (int* buffer : buffers) {
+        budget->Release(buffer, block_bytes);
+    }
+    budget->Unreserve(overhead_bytes);
+    return ok && !writer->Failed();
+}
+
+// Внешняя сортировка, когда окно из 2k чисел не помещается в память:
+// сортируем куски, сколько влезает, пишем во временный файл
+// и сливаем их по несколько за проход, пока не останется один.
+bool SortByRuns(int input_fd, int output_fd, const char* temp_directory,
+                MemoryBudget* budget, size_t block_ints) {
+    size_t block_bytes = block_ints * sizeof(int);
+    struct stat input_stat;
+    if (fstat(input_fd, &input_stat) != 0) {
+        return false;
+    }
+    // Кусок не короче блока, поэтому кусков не больше, чем блоков во входе.
+    // Описания кусков до и после прохода слияния учитываем сразу
+    size_t max_runs = input_stat.st_size / block_bytes + 1;
+    size_t runs_bytes = 2 * max_runs * sizeof(SortedRun);
+    if (!budget->Reserve(runs_bytes)) {
+        return false;
+    }
+    int run_fd = OpenTemporaryFile(temp_directory);
+    if (run_fd == -1) {
+        budget->Unreserve(runs_bytes);
+        return false;
+    }
+    // Кусок и буфер для его сортировки занимают всю свободную память
+    size_t run_ints = budget->Available() / (2 * sizeof(int));
+    run_ints = std::min<size_t>(run_ints, 1u << 30);
+    int* run = static_cast<int*>(budget->Allocate(run_ints * 2 * sizeof(int)));
+    if (!run || run_ints < block_ints) {
+        if (run) {
+            budget->Release(run, run_ints * 2 * sizeof(int));
+        }
+        budget->Unreserve(runs_bytes);
+        close(run_fd);
+        return false;
+    }
+    std::vector<SortedRun> runs;
+    runs.reserve(max_runs);
+    off_t offset = 0;
+    bool ok = true;
+    while (ok) {
+        ssize_t count = ReadUpTo(input_fd, run, run_ints);
+        if (count <= 0) {
+            ok = count == 0;
+            break;
+        }
+        MergeSortWithBuffer(run, count, run + run_ints, CompareLess);
+        ok = WriteAll(run_fd, run, count);
+        SortedRun sorted_run;
+        sorted_run.begin = offset;
+        offset += count * sizeof(int);
+        sorted_run.end = offset;
+        runs.push_back(sorted_run);
+    }
+    budget->Release(run, run_ints * 2 * sizeof(int));
+
+    // Один блок на запись, на каждый сливаемый кусок - блок чтения,
+    // читатель и место в куче
+    int* write_buffer = static_cast<int*>(budget->Allocate(block_bytes));
+    size_t fan_in = write_buffer
+        ? budget->Available() / (block_bytes + kMergeRunOverhead) : 0;
+    ok = ok && write_buffer && fan_in >= 2;
+    while (ok && runs.size() > fan_in) {
+        // Промежуточный проход: сливаем группы кусков в новый файл
+        int merged_fd = OpenTemporaryFile(temp_directory);
+        if (merged_fd == -1) {
+            ok = false;
+            break;
+        }
+        BlockWriter writer(merged_fd, write_buffer, block_ints);
+        std::vector<SortedRun> merged_runs;
+        merged_runs.reserve(runs.size() / fan_in + 1);
+        off_t merged_offset = 0;
+        for (size_t i = 0; i < runs.size() && ok; i += fan_in) {
+            size_t group = std::min(fan_in, runs.size() - i);
+            ok = MergeRuns(run_fd, &runs[i], group, &writer, budget, block_ints);
+            writer.Flush();
+            SortedRun merged_run;
+            merged_run.begin = merged_offset;
+            merged_run.end = runs[i + group - 1].end - runs[i].begin +
+                             merged_offset;
+            merged_offset = merged_run.end;
+            merged_runs.push_back(merged_run);
+        }
+        ok = ok && !writer.Failed();
+        close(run_fd);
+        run_fd = merged_fd;
+        runs.swap(merged_runs);
+    }
+    if (ok) {
+        BlockWriter writer(output_fd, write_buffer, block_ints);
+        ok = MergeRuns(run_fd, runs.data(), runs.size(), &writer, budget,
+                       block_ints);
+        writer.Flush();
+        ok = ok && !writer.Failed();
+    }
+    if (write_buffer) {
+        budget->Release(write_buffer, block_bytes);
+    }
+    budget->Unreserve(runs_bytes);
+    close(run_fd);
+    return ok;
+}
+
+// Сортировка почти упорядоченного файла в другой файл.
+// Файлы - это массивы int в двоичном виде, memory_limit - сколько байт
+// можно занять под окно и буферы. Если окно из 2k чисел помещается,
+// файл сортируется за один проход, иначе сортируются и сливаются куски.
+bool SortKSortedFile(const char* input_path, const char* output_path, int k,
+                     size_t memory_limit) {
+    int input_fd = open(input_path, O_RDONLY);
+    if (input_fd == -1) {
+        return false;
+    }
+    int output_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output_fd == -1) {
+        close(input_fd);
+        return false;
+    }
+    posix_fadvise(input_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    MemoryBudget budget(memory_limit);
+    // Блок ввода-вывода - шестнадцатая часть лимита, от 4 КБ до 1 МБ
+    size_t block_bytes = memory_limit / 16 / kIoAlignment * kIoAlignment;
+    block_bytes = std::max(kIoAlignment, std::min<size_t>(block_bytes, 1 << 20));
+    size_t block_ints = block_bytes / sizeof(int);
+
+    // Окно с буфером занимают 4k чисел, плюс блоки чтения и записи
+    size_t window_bytes = 4 * static_cast<size_t>(k) * sizeof(int);
+    bool ok = false;
+    if (k > 0 && window_bytes + 2 * block_bytes <= memory_limit) {
+        bool reserved = budget.Reserve(window_bytes);
+        int* read_buffer = static_cast<int*>(budget.Allocate(block_bytes));
+        int* write_buffer = static_cast<int*>(budget.Allocate(block_bytes));
+        struct stat input_stat;
+        ok = reserved && read_buffer && write_buffer &&
+             fstat(input_fd, &input_stat) == 0;
+        if (ok) {
+            BlockReader reader(input_fd, 0, input_stat.st_size, read_buffer,
+                               block_ints);
+            BlockWriter writer(output_fd, write_buffer, block_ints);
+            KSortedStreamSorter<BlockWriter> sorter(k, &writer);
+            ok = sorter.Allocated();
+            int value = 0;
+            while (ok && reader.Next(&value)) {
+                sorter.Push(value);
             }
+            if (ok) {
+                sorter.Finish();
+                ok = !reader.Failed() && !writer.Failed();
+            }
+        }
+        if (write_buffer) {
+            budget.Release(write_buffer, block_bytes);
         }
-        // Читаем оставшиеся n % k чисел
-        for (int i = k - n % k; i < k; i++) {
-            // Записываем их вплотную к последним k чисел
-            std::cin >> arr[i];
+        if (read_buffer) {
+            budget.Release(read_buffer, block_bytes);
         }
-        MergeSort(&arr[k - n % k], n % k + k, CompareLess);
-        // Выводим n % k + k (те самые k, которые оставались в массиве)
-        for (int i = k - n % k; i < 2 * k; i++) {
-            std::cout << arr[i] << " ";
+        if (reserved) {
+            budget.Unreserve(window_bytes);
+        }
+    } else {
+        std::string directory(output_path);
+        size_t slash = directory.rfind('/');
+        directory = slash == std::string::npos ? "." : directory.substr(0, slash);
+        ok = SortByRuns(input_fd, output_fd, directory.c_str(), &budget,
+                        block_ints);
+    }
+    close(input_fd);
+    ok = close(output_fd) == 0 && ok;
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    // Режим файл-в-файл: main input output k [memory_limit_mb]
+    if (argc >= 4) {
+        size_t memory_limit_mb = argc >= 5 ? atoll(argv[4]) : 1024;
+        if (!SortKSortedFile(argv[1], argv[2], atoi(argv[3]),
+                             memory_limit_mb << 20)) {
+            std::cerr << "external sort failed" << std::endl;
+            return 1;
         }
+        return 0;
+    }
+    std::ios::sync_with_stdio(false);
+    int n = 0;
+    int k = 0;
+    std::cin >> n >> k;
+    BufferedWriter writer(stdout);
+    KSortedStreamSorter<BufferedWriter> sorter(k, &writer);
+    if (!sorter.Allocated()) {
+        std::cerr << "not enough memory for k = " << k << std::endl;
+        return 1;
+    }
+    int value = 0;
+    for (int i = 0; i < n; i++) {
+        std::cin >> value;
+        sorter.Push(value);
     }
-    delete[] arr;
+    sorter.Finish();
     return 0;
 }
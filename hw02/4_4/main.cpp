@@ -33,68 +33,950 @@ Out:
 1
 */
 
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <cstdlib>
 #include <ctime>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SELECT_HAVE_AVX2 1
+#endif
 
-// Возвращает индекс, на который pivot встанет после разделения.
-int partition(int* a, int head, int tail) {
-    srand(time(NULL));
-    // Выбираем случайный индекс от head до tail
-    int p = head + rand() % (tail - head + 1);
-    int pivot = a[p];
-    std::swap(a[p], a[head]);
+// Быстрый генератор псевдослучайных чисел xorshift64
+class XorShiftRandom {
+ public:
+    explicit XorShiftRandom(uint64_t seed)
+        : state(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+    uint64_t Next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // Число из [0, bound): умножение вместо rand() % bound,
+    // без деления и без заметного перекоса
+    int NextBelow(int bound) {
+        return static_cast<int>(((Next() >> 32) * static_cast<uint64_t>(bound)) >> 32);
+    }
+
+ private:
+    uint64_t state = 0;
+};
+
+// Меньше этого размера опорный - медиана трех, иначе - медиана медиан трех
+const int kNintherThreshold = 128;
+// Сколько элементов (в единицах n) можно разделить со случайными
+// опорными, прежде чем перейти на медиану медиан. Ожидаемая работа
+// случайного выбора около 3n, поэтому обычно до запасного пути не доходит,
+// а в худшем случае суммарная работа все равно O(n).
+const int64_t kWorkBudgetFactor = 8;
+
+// Разделение методом прохода двумя итераторами от конца к началу.
+// Первый проход собирает в конце куска элементы больше опорного
+// и ставит опорный на границу. Второй проход тем же способом по левой
+// части отделяет элементы, равные опорному, иначе на повторах значений
+// выбор не продвигался бы. Итог - три части: < pivot, == pivot, > pivot.
+// Возвращает границы части, равной опорному элементу.
+std::pair<int, int> partition(int* a, int head, int tail, int pivot_index) {
+    int pivot = a[pivot_index];
+    std::swap(a[pivot_index], a[head]);
     // i указывает на начало группы элементов,
-    // не больших опорного (считая с конца)
+    // больших опорного (считая с конца)
     int i = tail;
     // j указывает на рассматриваемый элемент
-    int j = tail;
-    while (j > head) {
+    for (int j = tail; j > head; j--) {
         if (a[j] > pivot) {
             std::swap(a[j], a[i]);
             i--;
         }
-        j--;
     }
     std::swap(a[i], a[head]);
-    return i;
+    // В [head, i) все элементы не больше опорного. Второй проход
+    // собирает равные опорному перед i, начало их группы - equal_begin
+    int equal_begin = i;
+    for (int j = i - 1; j >= head; j--) {
+        if (a[j] == pivot) {
+            equal_begin--;
+            std::swap(a[j], a[equal_begin]);
+        }
+    }
+    return std::make_pair(equal_begin, i);
 }
 
-// Возвращает k-ю порядковую статистику
-// (1-я статистика при k = 0, вторая при k = 1 и т.д.)
-int find_kth_order_statistic(int* a, int n, int k) {
-    int head = 0; 
-    int tail = n - 1;
-    int i = 0;
-    bool found_k_flag = false;
-    while (!found_k_flag) {
-        i = partition(a, head, tail);
-        if (i == k) {
-            // Если индекс совпал, то мы нашли статистику
-            found_k_flag = true;
-        } else if (i > k) {
-            // Обновляем индекс конца части массива, в которой ищем
-            tail = i - 1;
+#ifdef SELECT_HAVE_AVX2
+// Меньше этого размера векторное разделение не окупается
+const int kVectorPartitionThreshold = 64;
+
+// Таблица перестановок для сжатия вектора по маске:
+// сначала индексы элементов с установленным битом, затем остальных
+struct CompressTable {
+    CompressTable() {
+        for (int mask = 0; mask < 256; mask++) {
+            int count = 0;
+            for (int lane = 0; lane < 8; lane++) {
+                if (mask & (1 << lane)) {
+                    indices[mask][count++] = lane;
+                }
+            }
+            for (int lane = 0; lane < 8; lane++) {
+                if (!(mask & (1 << lane))) {
+                    indices[mask][count++] = lane;
+                }
+            }
+        }
+    }
+
+    alignas(32) int indices[256][8];
+};
+
+const CompressTable& compress_table() {
+    static const CompressTable table;
+    return table;
+}
+
+// Раскладывает 8 чисел: меньшие опорного в начало левой части,
+// остальные в конец правой. Оба сохранения пишут по 8 чисел целиком,
+// поэтому перед вызовом с обеих сторон должно быть по 8 свободных мест.
+__attribute__((target("avx2")))
+static inline void split_vector(__m256i values, __m256i pivot,
+                                const CompressTable& table,
+                                int** write_left, int** write_right) {
+    __m256i less = _mm256_cmpgt_epi32(pivot, values);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(less));
+    int count = __builtin_popcount(mask);
+    __m256i permutation = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(table.indices[mask]));
+    __m256i permuted = _mm256_permutevar8x32_epi32(values, permutation);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(*write_left), permuted);
+    *write_left += count;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(*write_right - 8), permuted);
+    *write_right -= 8 - count;
+}
+
+// Векторное разделение [head, tail] на месте: < pivot и >= pivot.
+// Возвращает индекс первого элемента, не меньшего опорного.
+// Первые и последние 8 чисел откладываются в регистры, освобождая
+// по блоку с каждого края; дальше блок читается с той стороны,
+// где свободного места меньше, поэтому записи не затирают непрочитанное.
+__attribute__((target("avx2")))
+int partition_less_avx2(int* a, int head, int tail, int pivot_value) {
+    assert(tail - head + 1 >= 16);
+    const CompressTable& table = compress_table();
+    __m256i pivot = _mm256_set1_epi32(pivot_value);
+    int* write_left = a + head;
+    int* write_right = a + tail + 1;
+    __m256i first = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(write_left));
+    __m256i last = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(write_right - 8));
+    int* read_left = write_left + 8;
+    int* read_right = write_right - 8;
+    while (read_right - read_left >= 8) {
+        __m256i values;
+        if (read_left - write_left <= write_right - read_right) {
+            values = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(read_left));
+            read_left += 8;
+        } else {
+            read_right -= 8;
+            values = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(read_right));
+        }
+        split_vector(values, pivot, table, &write_left, &write_right);
+    }
+    // Непрочитанный остаток и последний блок переносим во временный массив,
+    // после чего между write_left и write_right свободно 16 + rest мест
+    int rest = static_cast<int>(read_right - read_left);
+    int buffer[16];
+    memcpy(buffer, read_left, sizeof(int) * rest);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + rest), last);
+    split_vector(first, pivot, table, &write_left, &write_right);
+    for (int i = 0; i < rest + 8; i++) {
+        if (buffer[i] < pivot_value) {
+            *write_left++ = buffer[i];
         } else {
+            *--write_right = buffer[i];
+        }
+    }
+    assert(write_left == write_right);
+    return static_cast<int>(write_left - a);
+}
+#endif
+
+// Индекс медианы из трех элементов
+int median_of_3(const int* a, int i, int j, int k) {
+    if (a[i] < a[j]) {
+        if (a[j] < a[k]) return j;
+        return a[i] < a[k] ? k : i;
+    }
+    if (a[i] < a[k]) return i;
+    return a[j] < a[k] ? k : j;
+}
+
+// Случайный опорный элемент: медиана трех случайных
+// или медиана трех медиан (ninther) для больших кусков
+int choose_pivot(const int* a, int head, int tail, XorShiftRandom* random) {
+    int size = tail - head + 1;
+    if (size < kNintherThreshold) {
+        return median_of_3(a, head + random->NextBelow(size),
+                           head + random->NextBelow(size),
+                           head + random->NextBelow(size));
+    }
+    int medians[3];
+    for (int i = 0; i < 3; i++) {
+        medians[i] = median_of_3(a, head + random->NextBelow(size),
+                                 head + random->NextBelow(size),
+                                 head + random->NextBelow(size));
+    }
+    return median_of_3(a, medians[0], medians[1], medians[2]);
+}
+
+// Сортировка вставками маленького куска [head, tail]
+void insertion_sort(int* a, int head, int tail) {
+    for (int i = head + 1; i <= tail; i++) {
+        int value = a[i];
+        int j = i;
+        for (; j > head && a[j - 1] > value; j--) {
+            a[j] = a[j - 1];
+        }
+        a[j] = value;
+    }
+}
+
+// Переносит медианы пятерок куска [head, tail] в его начало
+// и возвращает их количество
+int gather_group_medians(int* a, int head, int tail) {
+    int count = 0;
+    for (int i = head; i <= tail; i += 5) {
+        int group_tail = std::min(i + 4, tail);
+        insertion_sort(a, i, group_tail);
+        std::swap(a[head + count], a[(i + group_tail) / 2]);
+        count++;
+    }
+    return count;
+}
+
+// Кусок [head, tail], в котором ищется k-я статистика,
+// и сколько еще можно разделять со случайными опорными
+struct SelectFrame {
+    int head;
+    int tail;
+    int k;
+    int64_t work_budget;
+};
+
+// Каждый вложенный кусок медиан в 5 раз меньше внешнего,
+// поэтому для int-индексов хватает 14 уровней
+const int kMaxSelectDepth = 16;
+
+// Ставит на место k элемент, который стоял бы там после сортировки
+// куска [head, tail], и возвращает его.
+// Без рекурсии: когда случайные опорные исчерпали бюджет, медиана медиан
+// пятерок ищется тем же циклом во вложенном куске на стеке frames,
+// а после его завершения внешний кусок делится по найденному элементу.
+int select_in_range(int* a, int head, int tail, int k, XorShiftRandom* random) {
+#ifdef SELECT_HAVE_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+    SelectFrame frames[kMaxSelectDepth];
+    int depth = 0;
+    frames[depth++] = {head, tail, k, kWorkBudgetFactor * (tail - head + 1)};
+    // Опорный элемент, найденный вложенным куском, или -1
+    int pivot_index = -1;
+    while (true) {
+        SelectFrame& frame = frames[depth - 1];
+        int size = frame.tail - frame.head + 1;
+        if (pivot_index < 0) {
+            if (frame.head >= frame.tail) {
+                // Статистика куска на месте
+                if (depth == 1) {
+                    break;
+                }
+                pivot_index = frame.k;
+                depth--;
+                continue;
+            }
+#ifdef SELECT_HAVE_AVX2
+            // Векторное разделение на две части со случайным опорным
+            if (has_avx2 && frame.work_budget > 0 &&
+                size >= kVectorPartitionThreshold) {
+                int pivot = a[choose_pivot(a, frame.head, frame.tail, random)];
+                int middle = partition_less_avx2(a, frame.head, frame.tail, pivot);
+                frame.work_budget -= size;
+                if (frame.k < middle) {
+                    frame.tail = middle - 1;
+                    continue;
+                }
+                if (middle > frame.head) {
+                    frame.head = middle;
+                    continue;
+                }
+                // Опорный оказался минимумом, и левая часть пуста.
+                // Отделяем равные ему вторым проходом, иначе на повторах
+                // значений разделение не продвигалось бы.
+                int equal_end = frame.tail + 1;
+                if (pivot < INT32_MAX) {
+                    equal_end = partition_less_avx2(a, frame.head, frame.tail,
+                                                    pivot + 1);
+                    frame.work_budget -= size;
+                }
+                if (frame.k < equal_end) {
+                    frame.head = frame.tail = frame.k;
+                } else {
+                    frame.head = equal_end;
+                }
+                continue;
+            }
+#endif
+            if (frame.work_budget > 0) {
+                pivot_index = choose_pivot(a, frame.head, frame.tail, random);
+            } else if (size <= 5) {
+                insertion_sort(a, frame.head, frame.tail);
+                frame.head = frame.tail = frame.k;
+                continue;
+            } else {
+                // Опорный - медиана медиан пятерок. По обе стороны от него
+                // остается не меньше 3/10 элементов, что гарантирует
+                // линейное время. Ищем ее во вложенном куске.
+                int count = gather_group_medians(a, frame.head, frame.tail);
+                assert(depth < kMaxSelectDepth);
+                frames[depth++] = {frame.head, frame.head + count - 1,
+                                   frame.head + count / 2,
+                                   kWorkBudgetFactor * count};
+                continue;
+            }
+        }
+        frame.work_budget -= size;
+        std::pair<int, int> equal = partition(a, frame.head, frame.tail, pivot_index);
+        pivot_index = -1;
+        if (frame.k < equal.first) {
+            // Обновляем индекс конца части массива, в которой ищем
+            frame.tail = equal.first - 1;
+        } else if (frame.k > equal.second) {
             // Обновляем индекс начала части массива
-            head = i + 1;
+            frame.head = equal.second + 1;
+        } else {
+            // k попал в часть, равную опорному - статистика найдена
+            frame.head = frame.tail = frame.k;
         }
     }
-    // Статистика на своем месте, возвращаем ее
     return a[k];
 }
 
-int main() {
+// Опорный элемент "медиана медиан пятерок" для выбора нескольких статистик.
+// Медиана медиан ищется нерекурсивным select_in_range на куске в 5 раз меньше.
+int median_of_medians(int* a, int head, int tail, XorShiftRandom* random) {
+    int size = tail - head + 1;
+    if (size <= 5) {
+        insertion_sort(a, head, tail);
+        return head + size / 2;
+    }
+    int count = gather_group_medians(a, head, tail);
+    int middle = head + count / 2;
+    select_in_range(a, head, head + count - 1, middle, random);
+    return middle;
+}
+
+// Возвращает k-ю порядковую статистику
+// (1-я статистика при k = 0, вторая при k = 1 и т.д.)
+int find_kth_order_statistic(int* a, int n, int k) {
+    // Генератор заводится один раз на запрос и передается вниз
+    XorShiftRandom random(static_cast<uint64_t>(time(NULL)) * 2654435761u + k);
+    return select_in_range(a, 0, n - 1, k, &random);
+}
+
+// Возвращает статистики для всех индексов из ks (в том же порядке).
+// Один проход: после разделения продолжаем только в тех частях,
+// где остались запрошенные индексы.
+std::vector<int> find_kth_order_statistics(int* a, int n,
+                                           const std::vector<int>& ks) {
+    std::vector<int> sorted_ks(ks);
+    std::sort(sorted_ks.begin(), sorted_ks.end());
+    sorted_ks.erase(std::unique(sorted_ks.begin(), sorted_ks.end()),
+                    sorted_ks.end());
+
+    // Кусок массива и диапазон индексов sorted_ks, попадающих в него
+    struct Task {
+        int head;
+        int tail;
+        int first_k;
+        int last_k;
+    };
+    std::vector<Task> tasks;
+    if (!sorted_ks.empty()) {
+        tasks.push_back({0, n - 1, 0, static_cast<int>(sorted_ks.size()) - 1});
+    }
+    XorShiftRandom random(static_cast<uint64_t>(time(NULL)));
+    // Работа растет как n * log(количество индексов)
+    int64_t work_budget = kWorkBudgetFactor * n;
+    for (size_t m = sorted_ks.size(); m > 1; m /= 2) {
+        work_budget += kWorkBudgetFactor * n;
+    }
+    while (!tasks.empty()) {
+        Task task = tasks.back();
+        tasks.pop_back();
+        if (task.head >= task.tail) {
+            continue;
+        }
+        // Один индекс - обычный выбор
+        if (task.first_k == task.last_k) {
+            select_in_range(a, task.head, task.tail, sorted_ks[task.first_k],
+                            &random);
+            continue;
+        }
+        int size = task.tail - task.head + 1;
+        int pivot_index = work_budget > 0
+            ? choose_pivot(a, task.head, task.tail, &random)
+            : median_of_medians(a, task.head, task.tail, &random);
+        work_budget -= size;
+        std::pair<int, int> equal =
+            partition(a, task.head, task.tail, pivot_index);
+        // Индексы левее равной части и правее нее
+        int left_last = static_cast<int>(
+            std::lower_bound(sorted_ks.begin() + task.first_k,
+                             sorted_ks.begin() + task.last_k + 1,
+                             equal.first) - sorted_ks.begin()) - 1;
+        int right_first = static_cast<int>(
+            std::upper_bound(sorted_ks.begin() + task.first_k,
+                             sorted_ks.begin() + task.last_k + 1,
+                             equal.second) - sorted_ks.begin());
+        if (left_last >= task.first_k) {
+            tasks.push_back({task.head, equal.first - 1, task.first_k, left_last});
+        }
+        if (right_first <= task.last_k) {
+            tasks.push_back({equal.second + 1, task.tail, right_first, task.last_k});
+        }
+    }
+    std::vector<int> result;
+    result.reserve(ks.size());
+    for (int k : ks) {
+        result.push_back(a[k]);
+    }
+    return result;
+}
+
+// Начиная с этого размера main с флагом --parallel использует
+// параллельный выбор
+const int64_t kParallelSelectThreshold = 1 << 22;
+// Размер выборки для поиска границ
+const int64_t kSampleSize = 1 << 16;
+
+// Границы полосы, в которой ищется статистика. Граница, которой нет,
+// означает "без ограничения" с этой стороны.
+struct SelectBand {
+    bool has_low;
+    bool has_high;
+    int low;
+    int high;
+
+    // Куда попадает значение: 0 - меньше low, 1 - равно low,
+    // 2 - строго между границами, 3 - равно high (при high != low),
+    // 4 - больше high
+    int Classify(int value) const {
+        if (has_low && value <= low) {
+            return value < low ? 0 : 1;
+        }
+        if (has_high && value >= high) {
+            return value > high ? 4 : 3;
+        }
+        return 2;
+    }
+};
+
+// Сколько элементов попало в каждую часть относительно полосы
+struct BandCounts {
+    int64_t parts[5] = {};
+
+    void Add(const BandCounts& other) {
+        for (int i = 0; i < 5; i++) {
+            parts[i] += other.parts[i];
+        }
+    }
+};
+
+int find_kth_order_statistic_radix(const int* a, int64_t n, int64_t k);
+
+// Параллельный выбор для очень больших массивов, массив не изменяется.
+// По случайной выборке выбираются две границы, между которыми с большой
+// вероятностью лежит k-я статистика. Потоки параллельно считают элементы
+// меньше, равные и больше границ. Если k попал на значение границы
+// (на повторах значений это обычный случай), ответ - сама граница.
+// Иначе копируются только элементы строго между границами,
+// и в этой маленькой полосе статистика ищется обычным выбором.
+int find_kth_order_statistic_parallel(const int* a, int64_t n, int64_t k,
+                                      int threads_count) {
+    threads_count = std::max(1, threads_count);
+    XorShiftRandom random(static_cast<uint64_t>(time(NULL)) ^ n);
+    int64_t sample_size = std::min(n, kSampleSize);
+    std::vector<int> sample(sample_size);
+    for (int64_t i = 0; i < sample_size; i++) {
+        uint64_t index = random.Next() % static_cast<uint64_t>(n);
+        sample[i] = a[index];
+    }
+    std::sort(sample.begin(), sample.end());
+    // Ранг k в выборке и запас вокруг него в несколько стандартных отклонений
+    int64_t sample_rank = k * sample_size / n;
+    int64_t spread = static_cast<int64_t>(3 * std::sqrt(double(sample_size))) + 1;
+
+    std::vector<BandCounts> thread_counts(threads_count);
+    int64_t chunk = (n + threads_count - 1) / threads_count;
+    // Наибольший запас, с которым статистика не попала в полосу,
+    // и наименьший, с которым середина полосы не индексируется int (0 - не было).
+    // При промахе запас удваивается, пока полоса не станет всем массивом,
+    // а после слишком широкой полосы ищется делением пополам между ними.
+    int64_t missed_spread = -1;
+    int64_t too_wide_spread = 0;
+    while (true) {
+        int64_t low_rank = sample_rank - spread;
+        int64_t high_rank = sample_rank + spread;
+        SelectBand band;
+        band.has_low = low_rank >= 0;
+        band.has_high = high_rank < sample_size;
+        band.low = band.has_low ? sample[low_rank] : 0;
+        band.high = band.has_high ? sample[high_rank] : 0;
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threads_count; t++) {
+            threads.emplace_back([&, t] {
+                int64_t begin = std::min(n, t * chunk);
+                int64_t end = std::min(n, begin + chunk);
+                BandCounts counts;
+                for (int64_t i = begin; i < end; i++) {
+                    counts.parts[band.Classify(a[i])]++;
+                }
+                thread_counts[t] = counts;
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        BandCounts total;
+        for (int t = 0; t < threads_count; t++) {
+            total.Add(thread_counts[t]);
+        }
+        // Начала частей в отсортированном порядке
+        int64_t equal_low_begin = total.parts[0];
+        int64_t inside_begin = equal_low_begin + total.parts[1];
+        int64_t equal_high_begin = inside_begin + total.parts[2];
+        int64_t greater_begin = equal_high_begin + total.parts[3];
+        if (k < equal_low_begin || k >= greater_begin) {
+            // Статистика не попала в полосу - расширяем ее
+            missed_spread = spread;
+            spread = too_wide_spread > 0 ? (spread + too_wide_spread) / 2
+                                         : spread * 2;
+            if (spread == missed_spread) {
+                return find_kth_order_statistic_radix(a, n, k);
+            }
+            continue;
+        }
+        if (k < inside_begin) {
+            return band.low;
+        }
+        if (k >= equal_high_begin) {
+            return band.high;
+        }
+        if (total.parts[2] > INT32_MAX) {
+            // Середина не индексируется int - сужаем полосу. Если сужать
+            // уже некуда, считаем гистограммами, им копия не нужна.
+            too_wide_spread = spread;
+            spread = (missed_spread + spread) / 2;
+            if (spread == missed_spread) {
+                return find_kth_order_statistic_radix(a, n, k);
+            }
+            continue;
+        }
+
+        // Каждый поток копирует свою часть середины со своего смещения
+        std::vector<int> inside(total.parts[2]);
+        int64_t offset = 0;
+        threads.clear();
+        for (int t = 0; t < threads_count; t++) {
+            threads.emplace_back([&, t, offset] {
+                int64_t begin = std::min(n, t * chunk);
+                int64_t end = std::min(n, begin + chunk);
+                int* out = inside.data() + offset;
+                for (int64_t i = begin; i < end; i++) {
+                    if (band.Classify(a[i]) == 2) {
+                        *out++ = a[i];
+                    }
+                }
+            });
+            offset += thread_counts[t].parts[2];
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return select_in_range(inside.data(), 0,
+                               static_cast<int>(total.parts[2]) - 1,
+                               static_cast<int>(k - inside_begin), &random);
+    }
+}
+
+// Разрядов в одном проходе выбора по гистограммам: 15 + 15 покрывают [0, 2^30)
+const int kRadixBits = 15;
+
+// Добавляет в гистограмму counts разряды (value >> shift) & mask
+// для элементов, у которых старшие разряды (value >> match_shift)
+// равны match. Счет идет в четыре независимые гистограммы,
+// чтобы соседние элементы не ждали друг друга на одной ячейке.
+void fill_histograms(const int* a, int64_t n, int shift, int match_shift,
+                     int match, uint32_t* counts) {
+    const int buckets = 1 << kRadixBits;
+    const int mask = buckets - 1;
+    uint32_t* c0 = counts;
+    uint32_t* c1 = counts + buckets;
+    uint32_t* c2 = counts + 2 * buckets;
+    uint32_t* c3 = counts + 3 * buckets;
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        // Без ветвлений: неподходящий элемент увеличивает счетчик на 0
+        c0[(a[i] >> shift) & mask] += (a[i] >> match_shift) == match;
+        c1[(a[i + 1] >> shift) & mask] += (a[i + 1] >> match_shift) == match;
+        c2[(a[i + 2] >> shift) & mask] += (a[i + 2] >> match_shift) == match;
+        c3[(a[i + 3] >> shift) & mask] += (a[i + 3] >> match_shift) == match;
+    }
+    for (; i < n; i++) {
+        c0[(a[i] >> shift) & mask] += (a[i] >> match_shift) == match;
+    }
+}
+
+// Находит корзину, в которой лежит элемент ранга *k,
+// и переводит *k в ранг внутри этой корзины
+int find_bucket(const uint32_t* counts, int64_t* k) {
+    const int buckets = 1 << kRadixBits;
+    for (int bucket = 0; bucket < buckets; bucket++) {
+        int64_t count = int64_t(counts[bucket]) + counts[buckets + bucket] +
+                        counts[2 * buckets + bucket] +
+                        counts[3 * buckets + bucket];
+        if (*k < count) {
+            return bucket;
+        }
+        *k -= count;
+    }
+    assert(false);
+    return buckets - 1;
+}
+
+// Выбор по гистограммам для чисел из [0, 2^30) (в задаче все числа
+// из [0..10^9]). Первый проход строит гистограмму по старшим 15 разрядам
+// и находит корзину с k-й статистикой, второй - гистограмму младших
+// разрядов только этой корзины. Элементы не сравниваются и не
+// переставляются, поэтому массив может быть только для чтения.
+// Первый проход считает только числа из [0, 2^30). Если какие-то
+// числа в него не попали, выбор идет разделением по копии массива.
+int find_kth_order_statistic_radix(const int* a, int64_t n, int64_t k) {
+    assert(k >= 0 && k < n);
+    const int buckets = 1 << kRadixBits;
+    std::vector<uint32_t> counts(4 * buckets);
+    fill_histograms(a, n, kRadixBits, 2 * kRadixBits, 0, counts.data());
+    int64_t in_domain = 0;
+    for (uint32_t count : counts) {
+        in_domain += count;
+    }
+    if (in_domain != n) {
+        assert(n <= INT32_MAX);
+        std::vector<int> copy(a, a + n);
+        return find_kth_order_statistic(copy.data(), static_cast<int>(n),
+                                        static_cast<int>(k));
+    }
+    int high = find_bucket(counts.data(), &k);
+    std::fill(counts.begin(), counts.end(), 0);
+    fill_histograms(a, n, 0, kRadixBits, high, counts.data());
+    int low = find_bucket(counts.data(), &k);
+    return (high << kRadixBits) | low;
+}
+
+// Потоковый скетч квантилей KLL. Хранит O(capacity) чисел независимо
+// от длины потока и отвечает на запрос ранга k с ошибкой ранга
+// порядка count / capacity. Скетчи, построенные на разных потоках
+// данных (например, в разных потоках), можно сливать.
+class QuantileSketch {
+ public:
+    explicit QuantileSketch(int _capacity = 256, uint64_t seed = 1);
+
+    // Добавление очередного числа из потока
+    void Add(int value);
+    // Слияние с другим скетчем
+    void Merge(const QuantileSketch& other);
+    // Сколько чисел было добавлено
+    int64_t Count() const { return count; }
+    // Приближенное значение с рангом k (0..Count()-1)
+    int Query(int64_t k) const;
+
+ private:
+    // Уровень h хранит числа с весом 2^h, верхние уровни вместительнее
+    int LevelCapacity(int level) const;
+    // Пересчитывает суммарную вместимость после появления уровня
+    void UpdateMaxSize();
+    // Сжимает самый нижний переполненный уровень: сортирует его
+    // и переносит каждое второе число (со случайным сдвигом) выше.
+    // Вызывается, только когда переполнен скетч целиком.
+    void Compress();
+
+    int capacity = 0;
+    int64_t count = 0;
+    // Сколько чисел хранится сейчас и сколько можно хранить
+    int size = 0;
+    int max_size = 0;
+    std::vector<std::vector<int>> levels;
+    XorShiftRandom random;
+};
+
+QuantileSketch::QuantileSketch(int _capacity, uint64_t seed)
+    : capacity(_capacity), levels(1), random(seed) {
+    assert(capacity >= 8);
+    UpdateMaxSize();
+}
+
+int QuantileSketch::LevelCapacity(int level) const {
+    // Вместимость падает в 3/2 раза с каждым уровнем сверху вниз
+    int depth = static_cast<int>(levels.size()) - 1 - level;
+    double level_capacity = capacity * std::pow(2.0 / 3.0, depth);
+    return std::max(2, static_cast<int>(std::ceil(level_capacity)));
+}
+
+void QuantileSketch::UpdateMaxSize() {
+    max_size = 0;
+    for (size_t level = 0; level < levels.size(); level++) {
+        max_size += LevelCapacity(level);
+    }
+}
+
+void QuantileSketch::Add(int value) {
+    levels[0].push_back(value);
+    count++;
+    size++;
+    if (size >= max_size) {
+        Compress();
+    }
+}
+
+void QuantileSketch::Compress() {
+    for (size_t level = 0; level < levels.size(); level++) {
+        if (static_cast<int>(levels[level].size()) < LevelCapacity(level)) {
+            continue;
+        }
+        if (level + 1 == levels.size()) {
+            levels.emplace_back();
+            UpdateMaxSize();
+        }
+        std::vector<int>& items = levels[level];
+        std::sort(items.begin(), items.end());
+        // При нечетном размере одно число остается на уровне
+        size_t kept = items.size() % 2;
+        size_t offset = kept + (random.Next() & 1);
+        for (size_t i = offset; i < items.size(); i += 2) {
+            levels[level + 1].push_back(items[i]);
+        }
+        size -= static_cast<int>((items.size() - kept) / 2);
+        items.resize(kept);
+        return;
+    }
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other) {
+    if (levels.size() < other.levels.size()) {
+        levels.resize(other.levels.size());
+        UpdateMaxSize();
+    }
+    for (size_t level = 0; level < other.levels.size(); level++) {
+        levels[level].insert(levels[level].end(), other.levels[level].begin(),
+                             other.levels[level].end());
+    }
+    count += other.count;
+    size += other.size;
+    while (size >= max_size) {
+        Compress();
+    }
+}
+
+int QuantileSketch::Query(int64_t k) const {
+    assert(count > 0);
+    // Пары (число, вес), отсортированные по числу
+    std::vector<std::pair<int, int64_t>> weighted;
+    for (size_t level = 0; level < levels.size(); level++) {
+        for (int value : levels[level]) {
+            weighted.emplace_back(value, int64_t(1) << level);
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+    int64_t rank = 0;
+    for (const std::pair<int, int64_t>& item : weighted) {
+        rank += item.second;
+        if (rank > k) {
+            return item.first;
+        }
+    }
+    return weighted.back().first;
+}
+
+// Гибридный выбор: скетчи, построенные параллельно и слитые в один,
+// дают границы, между которыми лежит k-я статистика, а точный выбор
+// идет только по числам между границами. Массив не изменяется.
+// Ответ точный, поэтому все числа должны лежать в памяти: скетч только
+// сужает выбор, а подсчет относительно границ проходит по всему массиву.
+// Приближенный ответ в памяти O(capacity) дает потоковый режим main.
+int find_kth_order_statistic_hybrid(const int* a, int64_t n, int64_t k,
+                                    int threads_count) {
+    threads_count = std::max(1, threads_count);
+    const int sketch_capacity = 512;
+    std::vector<QuantileSketch> sketches;
+    for (int t = 0; t < threads_count; t++) {
+        sketches.emplace_back(sketch_capacity, t + 1);
+    }
+    int64_t chunk = (n + threads_count - 1) / threads_count;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; t++) {
+        threads.emplace_back([&, t] {
+            int64_t begin = std::min(n, t * chunk);
+            int64_t end = std::min(n, begin + chunk);
+            for (int64_t i = begin; i < end; i++) {
+                sketches[t].Add(a[i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int t = 1; t < threads_count; t++) {
+        sketches[0].Merge(sketches[t]);
+    }
+    const QuantileSketch& sketch = sketches[0];
+    XorShiftRandom random(static_cast<uint64_t>(time(NULL)) ^ n);
+
+    // Запас по рангу - несколько допустимых ошибок скетча
+    int64_t margin = 4 * n / sketch_capacity + 1;
+    while (true) {
+        SelectBand band;
+        band.has_low = k - margin >= 0;
+        band.has_high = k + margin < n;
+        band.low = band.has_low ? sketch.Query(k - margin) : 0;
+        band.high = band.has_high ? sketch.Query(k + margin) : 0;
+        // Как и в параллельном выборе, копируется только середина полосы,
+        // а попадание k на значение границы отвечается сразу
+        BandCounts counts;
+        std::vector<int> inside;
+        for (int64_t i = 0; i < n; i++) {
+            int part = band.Classify(a[i]);
+            counts.parts[part]++;
+            if (part == 2) {
+                inside.push_back(a[i]);
+            }
+        }
+        int64_t equal_low_begin = counts.parts[0];
+        int64_t inside_begin = equal_low_begin + counts.parts[1];
+        int64_t equal_high_begin = inside_begin + counts.parts[2];
+        int64_t greater_begin = equal_high_begin + counts.parts[3];
+        if (k >= equal_low_begin && k < greater_begin) {
+            if (k < inside_begin) {
+                return band.low;
+            }
+            if (k >= equal_high_begin) {
+                return band.high;
+            }
+            if (counts.parts[2] > INT32_MAX) {
+                return find_kth_order_statistic_radix(a, n, k);
+            }
+            return select_in_range(inside.data(), 0,
+                                   static_cast<int>(counts.parts[2]) - 1,
+                                   static_cast<int>(k - inside_begin), &random);
+        }
+        // Оценка промахнулась - расширяем границы
+        margin *= 2;
+    }
+}
+
+// Проверка выбора по гистограммам на числах внутри и вне [0, 2^30):
+// отрицательные и большие числа должны уводить его на запасной путь
+bool RadixSelfTest() {
+    XorShiftRandom random(12345);
+    const int kSizes[] = {1, 7, 1000, 100000};
+    for (int size : kSizes) {
+        for (int domain = 0; domain < 3; domain++) {
+            std::vector<int> values(size);
+            for (int& value : values) {
+                uint32_t bits = static_cast<uint32_t>(random.Next() >> 32);
+                if (domain == 0) {
+                    value = static_cast<int>(bits % 1000000001u);
+                } else if (domain == 1) {
+                    // Отрицательные числа вперемешку с обычными
+                    value = static_cast<int>(bits % 2000000001u) - 1000000000;
+                } else {
+                    // Числа от 2^30 до INT32_MAX вперемешку с обычными
+                    value = static_cast<int>(bits & INT32_MAX);
+                }
+            }
+            std::vector<int> sorted(values);
+            std::sort(sorted.begin(), sorted.end());
+            for (int k : {0, size / 3, size - 1}) {
+                if (find_kth_order_statistic_radix(values.data(), size, k) !=
+                    sorted[k]) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Емкость скетча потокового режима: ошибка ранга порядка n / 4096
+const int kStreamSketchCapacity = 4096;
+
+// Без флагов ответ ищется выбором с разделением, как требует задача.
+// Остальные способы включаются флагами:
+// --radix - выбор по гистограммам, для больших массивов быстрее;
+// --parallel - параллельный выбор по выборке на всех ядрах
+// для массивов от kParallelSelectThreshold чисел;
+// --sketch - потоковый режим: числа не сохраняются, а по мере чтения
+// добавляются в скетч, поэтому память не зависит от n, но ответ
+// приближенный (его ранг отличается от k на доли процента n);
+// --self-test - только проверка выбора по гистограммам.
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "";
+    if (strcmp(mode, "--self-test") == 0) {
+        std::cout << (RadixSelfTest() ? "OK" : "FAIL") << std::endl;
+        return 0;
+    }
+    bool stream_mode = strcmp(mode, "--sketch") == 0;
     int n = 0;
     int k = 0;
     std::cin >> n >> k;
+
+    if (stream_mode) {
+        QuantileSketch sketch(kStreamSketchCapacity);
+        for (int i = 0; i < n; i++) {
+            int value = 0;
+            std::cin >> value;
+            sketch.Add(value);
+        }
+        std::cout << sketch.Query(k);
+        return 0;
+    }
+
     int* a = new int[n];
 
     for (int i = 0; i < n; i++) {
         std::cin >> a[i];
     }
 
-    std::cout << find_kth_order_statistic(a, n, k);
+    int threads_count = static_cast<int>(std::thread::hardware_concurrency());
+    if (strcmp(mode, "--parallel") == 0 && n >= kParallelSelectThreshold &&
+        threads_count > 1) {
+        std::cout << find_kth_order_statistic_parallel(a, n, k, threads_count);
+    } else if (strcmp(mode, "--radix") == 0) {
+        std::cout << find_kth_order_statistic_radix(a, n, k);
+    } else {
+        std::cout << find_kth_order_statistic(a, n, k);
+    }
     delete[] a;
     return 0;
 }
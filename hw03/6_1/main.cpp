@@ -34,106 +34,477 @@ out:
 3 1 4 2
 */
 
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <cstddef>
+#include <algorithm>
 #include <iostream>
-#include <stack>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <utility>
 #include <vector>
 
 
-// Узел бинарного дерева
-struct TreeNode {
-  explicit TreeNode(int _value) : value(_value) {}
+// Хранилище узлов бинарного дерева: структура массивов со значениями
+// и 32-битными индексами детей вместо указателей, 12 байт на узел.
+// Узлы не освобождаются по одному - все массивы удаляются разом.
+struct NodeArena {
+  // Индекс отсутствующего узла
+  static const uint32_t kNone = UINT32_MAX;
 
-  int value = 0;
-  TreeNode* left = nullptr;
-  TreeNode* right = nullptr;
+  // Создает узел без детей и возвращает его индекс
+  uint32_t Create(int value);
+  void Reserve(size_t count);
+  size_t Size() const { return value.size(); }
+
+  std::vector<int> value;
+  std::vector<uint32_t> left;
+  std::vector<uint32_t> right;
+};
+
+
+// Неизменяемый снимок дерева для быстрых поисков. Значения по возрастанию
+// разложены в массив в порядке Эйтцингера (как в двоичной куче: дети
+// узла k - узлы 2k и 2k + 1), поэтому верхние уровни поиска лежат рядом,
+// а узлы на несколько уровней вперед можно подгружать заранее.
+class FrozenTree {
+ public:
+  explicit FrozenTree(const std::vector<int>& sorted_values);
+
+  bool Find(int value) const;
+  // Наименьшее значение, не меньшее value. false, если такого нет
+  bool LowerBound(int value, int* result) const;
+  // Пакетная проверка наличия: поиски идут вперемешку,
+  // и пока ждем память для одного, считаем остальные
+  void FindMany(const int* queries, size_t count, bool* found) const;
+  size_t Size() const { return size; }
+
+ private:
+  // Номер (1..size) узла с нижней границей или 0
+  size_t LowerBoundIndex(int value) const;
+
+  size_t size = 0;
+  // layout[0] не используется, чтобы корень был в 1
+  std::vector<int> layout;
+};
+
+
+FrozenTree::FrozenTree(const std::vector<int>& sorted_values)
+    : size(sorted_values.size()), layout(sorted_values.size() + 1) {
+  if (size == 0) return;
+  // Заполняем неявное дерево в симметричном порядке без рекурсии:
+  // начинаем с самого левого узла и переходим к следующему по порядку
+  size_t k = 1;
+  while (2 * k <= size) k *= 2;
+  for (int value : sorted_values) {
+    layout[k] = value;
+    if (2 * k + 1 <= size) {
+      // Следующий - самый левый узел правого поддерева
+      k = 2 * k + 1;
+      while (2 * k <= size) k *= 2;
+    } else {
+      // Поднимаемся, пока приходим из правого поддерева
+      while (k & 1) k >>= 1;
+      k >>= 1;
+    }
+  }
+}
+
+size_t FrozenTree::LowerBoundIndex(int value) const {
+  const int* base = layout.data();
+  size_t k = 1;
+  while (k <= size) {
+    // 16 чисел - одна кэш-линия, это узлы на 4 уровня ниже
+    __builtin_prefetch(base + std::min(k * 16, size));
+    k = 2 * k + (base[k] < value);
+  }
+  // Убираем правые повороты после последнего левого,
+  // остается узел, где поиск последний раз ушел влево
+  k >>= __builtin_ffsll(~static_cast<long long>(k));
+  return k;
+}
+
+bool FrozenTree::Find(int value) const {
+  size_t k = LowerBoundIndex(value);
+  return k != 0 && layout[k] == value;
+}
+
+bool FrozenTree::LowerBound(int value, int* result) const {
+  size_t k = LowerBoundIndex(value);
+  if (k == 0) return false;
+  *result = layout[k];
+  return true;
+}
+
+void FrozenTree::FindMany(const int* queries, size_t count,
+                          bool* found) const {
+  const size_t kBatch = 16;
+  const int* base = layout.data();
+  size_t k[kBatch];
+  for (size_t start = 0; start < count; start += kBatch) {
+    size_t batch = std::min(kBatch, count - start);
+    for (size_t j = 0; j < batch; j++) k[j] = 1;
+    // Все поиски спускаются по уровням одновременно
+    bool active = size > 0;
+    while (active) {
+      active = false;
+      for (size_t j = 0; j < batch; j++) {
+        if (k[j] > size) continue;
+        k[j] = 2 * k[j] + (base[k[j]] < queries[start + j]);
+        __builtin_prefetch(base + std::min(k[j], size));
+        active = true;
+      }
+    }
+    for (size_t j = 0; j < batch; j++) {
+      size_t index = k[j] >> __builtin_ffsll(~static_cast<long long>(k[j]));
+      found[start + j] = index != 0 && base[index] == queries[start + j];
+    }
+  }
+}
+
+
+// Порядок обхода дерева
+enum class TraverseOrder {
+  kPreOrder,
+  kInOrder,
+  kPostOrder,
 };
 
 
 class Tree {
  public:
-  ~Tree();
+  class Traversal;
 
-  std::vector<TreeNode*> PreOrderTraverse() const;
+  // Заранее выделяет память под count узлов
+  void Reserve(size_t count);
+
+  std::vector<int> PreOrderTraverse() const;
+  // Ленивый обход в заданном порядке
+  Traversal Traverse(TraverseOrder order) const;
+  // Количество узлов на самом длинном пути от корня до листа
+  uint32_t Height() const { return height; }
+  // Поиск значения в дереве
+  bool Find(int value) const;
+  // Неизменяемый снимок для быстрых поисков
+  FrozenTree Freeze() const;
 
   void Add(int value);
+  // Добавляет числа по порядку за O(n log n). Получается то же дерево,
+  // что и при вызове Add для каждого числа, но без спуска от корня.
+  void BuildFromSequence(const std::vector<int>& values);
 
  private:
-  TreeNode* root = nullptr;
+  NodeArena nodes;
+  uint32_t root = NodeArena::kNone;
+  uint32_t height = 0;
 };
 
 
-Tree::~Tree() {
-  if (!root) return;
-  std::stack<TreeNode*> next_nodes;
-  // Добавляем корень на стек
-  next_nodes.push(root);
-  TreeNode* current_node = nullptr;
-  // Удаляем узлы, пока стек не опустеет
-  while (!next_nodes.empty()) {
-    current_node = next_nodes.top();
-    next_nodes.pop();
-    // Если есть дети, добавляем в стек
-    if  (current_node->right != nullptr) {
-      next_nodes.push(current_node->right);
-    }
-    if  (current_node->left != nullptr) {
-      next_nodes.push(current_node->left);
+// Ленивый обход дерева без рекурсии. Явный стек вместимостью
+// в высоту дерева выделяется один раз при создании обхода,
+// переход к следующему узлу память не выделяет.
+// Итераторы однопроходные: все они делят стек обхода.
+class Tree::Traversal {
+ public:
+  class Iterator {
+   public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef int value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const int* pointer;
+    typedef const int& reference;
+
+    const int& operator*() const { return traversal->nodes->value[node]; }
+    Iterator& operator++() {
+      node = traversal->Next(node);
+      return *this;
     }
-    delete current_node;
+    bool operator==(const Iterator& other) const { return node == other.node; }
+    bool operator!=(const Iterator& other) const { return node != other.node; }
+
+   private:
+    friend class Traversal;
+    Iterator(Traversal* _traversal, uint32_t _node)
+        : traversal(_traversal), node(_node) {}
+
+    Traversal* traversal = nullptr;
+    uint32_t node = NodeArena::kNone;
+  };
+
+  Traversal(const NodeArena* _nodes, uint32_t _root, uint32_t height,
+            TraverseOrder _order);
+
+  Iterator begin() { return Iterator(this, First()); }
+  Iterator end() { return Iterator(this, NodeArena::kNone); }
+
+ private:
+  // Первый узел обхода
+  uint32_t First();
+  // Узел, следующий за node, или kNone в конце
+  uint32_t Next(uint32_t node);
+  // Спуск от node до первого по post-order листа с запоминанием пути
+  uint32_t DescendToLeaf(uint32_t node);
+
+  void Push(uint32_t node) {
+    assert(stack_size < stack_capacity);
+    stack[stack_size++] = node;
   }
+  uint32_t Pop() { return stack[--stack_size]; }
+
+  const NodeArena* nodes = nullptr;
+  uint32_t root = NodeArena::kNone;
+  TraverseOrder order = TraverseOrder::kPreOrder;
+  std::unique_ptr<uint32_t[]> stack;
+  uint32_t stack_capacity = 0;
+  uint32_t stack_size = 0;
+};
+
+
+const uint32_t NodeArena::kNone;
+
+uint32_t NodeArena::Create(int _value) {
+  value.push_back(_value);
+  left.push_back(kNone);
+  right.push_back(kNone);
+  return static_cast<uint32_t>(value.size() - 1);
+}
+
+void NodeArena::Reserve(size_t count) {
+  value.reserve(count);
+  left.reserve(count);
+  right.reserve(count);
+}
+
+
+void Tree::Reserve(size_t count) {
+  nodes.Reserve(count);
 }
 
 
-// Возвращает вектор с указателями на узлы дерева в порядке pre-order обхода
-std::vector<TreeNode*> Tree::PreOrderTraverse() const {
-  std::stack<TreeNode*> next_nodes;
-  std::vector<TreeNode*> traversal;
-  // Добавляем корень на стек
-  next_nodes.push(root);
-  // Пока стек не опустеет,
-  // забираем указатели на элементы со стека в вектор
-  while (!next_nodes.empty()) {
-    traversal.push_back(next_nodes.top());
-    next_nodes.pop();
-    // Если есть дети, добавляем в стек
-    if  (traversal.back()->right != nullptr) {
-      next_nodes.push(traversal.back()->right);
+// Возвращает вектор со значениями узлов дерева в порядке pre-order обхода
+std::vector<int> Tree::PreOrderTraverse() const {
+  std::vector<int> traversal;
+  traversal.reserve(nodes.Size());
+  for (int value : Traverse(TraverseOrder::kPreOrder)) {
+    traversal.push_back(value);
+  }
+  return traversal;
+}
+
+bool Tree::Find(int value) const {
+  uint32_t current_node = root;
+  while (current_node != NodeArena::kNone) {
+    int current_value = nodes.value[current_node];
+    if (value == current_value) return true;
+    current_node = value < current_value ? nodes.left[current_node]
+                                         : nodes.right[current_node];
+  }
+  return false;
+}
+
+FrozenTree Tree::Freeze() const {
+  // Симметричный обход дает значения по возрастанию
+  std::vector<int> sorted_values;
+  sorted_values.reserve(nodes.Size());
+  for (int value : Traverse(TraverseOrder::kInOrder)) {
+    sorted_values.push_back(value);
+  }
+  return FrozenTree(sorted_values);
+}
+
+Tree::Traversal Tree::Traverse(TraverseOrder order) const {
+  return Traversal(&nodes, root, height, order);
+}
+
+
+Tree::Traversal::Traversal(const NodeArena* _nodes, uint32_t _root,
+                           uint32_t height, TraverseOrder _order)
+    : nodes(_nodes), root(_root), order(_order),
+      stack(new uint32_t[height + 1]), stack_capacity(height + 1) {}
+
+uint32_t Tree::Traversal::First() {
+  stack_size = 0;
+  if (root == NodeArena::kNone) return NodeArena::kNone;
+  switch (order) {
+    case TraverseOrder::kPreOrder:
+      return root;
+    case TraverseOrder::kInOrder: {
+      // Спускаемся влево до конца, запоминая путь
+      uint32_t node = root;
+      while (nodes->left[node] != NodeArena::kNone) {
+        Push(node);
+        node = nodes->left[node];
+      }
+      return node;
     }
-    if  (traversal.back()->left != nullptr) {
-      next_nodes.push(traversal.back()->left);
+    case TraverseOrder::kPostOrder:
+      return DescendToLeaf(root);
+  }
+  return NodeArena::kNone;
+}
+
+uint32_t Tree::Traversal::DescendToLeaf(uint32_t node) {
+  // Идем влево, а если левого ребенка нет - вправо
+  while (true) {
+    uint32_t child = nodes->left[node] != NodeArena::kNone
+        ? nodes->left[node] : nodes->right[node];
+    if (child == NodeArena::kNone) return node;
+    Push(node);
+    node = child;
+  }
+}
+
+uint32_t Tree::Traversal::Next(uint32_t node) {
+  uint32_t left = nodes->left[node];
+  uint32_t right = nodes->right[node];
+  switch (order) {
+    case TraverseOrder::kPreOrder:
+      // В стеке правые дети, до которых еще не дошли
+      if (left != NodeArena::kNone) {
+        if (right != NodeArena::kNone) Push(right);
+        return left;
+      }
+      if (right != NodeArena::kNone) return right;
+      return stack_size > 0 ? Pop() : NodeArena::kNone;
+    case TraverseOrder::kInOrder:
+      // В стеке предки, из которых ушли влево
+      if (right != NodeArena::kNone) {
+        node = right;
+        while (nodes->left[node] != NodeArena::kNone) {
+          Push(node);
+          node = nodes->left[node];
+        }
+        return node;
+      }
+      return stack_size > 0 ? Pop() : NodeArena::kNone;
+    case TraverseOrder::kPostOrder: {
+      // В стеке все предки текущего узла
+      if (stack_size == 0) return NodeArena::kNone;
+      uint32_t parent = stack[stack_size - 1];
+      // Из левого поддерева переходим в правое, если оно есть
+      if (nodes->left[parent] == node &&
+          nodes->right[parent] != NodeArena::kNone) {
+        return DescendToLeaf(nodes->right[parent]);
+      }
+      return Pop();
     }
   }
-  return traversal;
+  return NodeArena::kNone;
+}
+
+
+// Буферизированный вывод чисел прямо в файловый дескриптор
+class FdWriter {
+ public:
+  explicit FdWriter(int _fd) : fd(_fd) {}
+  ~FdWriter();
+
+  FdWriter(const FdWriter&) = delete;
+  FdWriter& operator=(const FdWriter&) = delete;
+
+  void WriteInt(int value);
+  void WriteChar(char c);
+  void Flush();
+
+ private:
+  static const size_t kBufferSize = 1 << 16;
+  // Самое длинное число: "-2147483648"
+  static const size_t kMaxIntLength = 11;
+
+  int fd = -1;
+  size_t used = 0;
+  char buffer[kBufferSize];
+};
+
+FdWriter::~FdWriter() {
+  Flush();
+}
+
+void FdWriter::WriteInt(int value) {
+  // Пары цифр "00".."99", чтобы делить на 100, а не на 10
+  static const char kDigitPairs[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233"
+      "34353637383940414243444546474849505152535455565758596061626364656667"
+      "6869707172737475767778798081828384858687888990919293949596979899";
+  if (used + kMaxIntLength > kBufferSize) Flush();
+  uint32_t magnitude = static_cast<uint32_t>(value);
+  if (value < 0) {
+    buffer[used++] = '-';
+    magnitude = 0u - magnitude;
+  }
+  // Собираем цифры с конца во временном массиве
+  char digits[10];
+  char* position = digits + sizeof(digits);
+  while (magnitude >= 100) {
+    uint32_t pair = magnitude % 100;
+    magnitude /= 100;
+    position -= 2;
+    memcpy(position, kDigitPairs + 2 * pair, 2);
+  }
+  if (magnitude >= 10) {
+    position -= 2;
+    memcpy(position, kDigitPairs + 2 * magnitude, 2);
+  } else {
+    *--position = static_cast<char>('0' + magnitude);
+  }
+  size_t length = digits + sizeof(digits) - position;
+  memcpy(buffer + used, position, length);
+  used += length;
+}
+
+void FdWriter::WriteChar(char c) {
+  if (used == kBufferSize) Flush();
+  buffer[used++] = c;
+}
+
+void FdWriter::Flush() {
+  size_t written = 0;
+  while (written < used) {
+    ssize_t result = write(fd, buffer + written, used - written);
+    if (result <= 0) break;
+    written += result;
+  }
+  used = 0;
 }
 
 // Добавление элемента в дерево
 void Tree::Add(int value) {
-  TreeNode* current_node = root;
+  uint32_t current_node = root;
   // Если дерево пусто, новый узел в корне
-  if (current_node == nullptr) {
-    root = new TreeNode(value);
+  if (current_node == NodeArena::kNone) {
+    root = nodes.Create(value);
+    height = 1;
     return;
   }
+  // Глубина нового узла нужна для высоты дерева
+  uint32_t depth = 2;
   // Выполняем цикл, пока не найдем подходящее место для узла
-  while (true) {
+  for (;; depth++) {
     // Если значение меньше, чем в текущем узле
-    if (value < current_node->value) {
+    if (value < nodes.value[current_node]) {
       // Если есть левый ребенок, то он станет текущим узлом
-      if (current_node->left) {
-        current_node = current_node->left;
+      if (nodes.left[current_node] != NodeArena::kNone) {
+        current_node = nodes.left[current_node];
       // Иначе, если левого ребенка нет, создаем новый узел
       } else {
-        current_node->left = new TreeNode(value);
+        uint32_t new_node = nodes.Create(value);
+        nodes.left[current_node] = new_node;
+        height = std::max(height, depth);
         return;
       }
     // Иначе, если значение больше или равно значения в текущем узле
     } else {
       // Если есть правый ребенок, то он станет текущим узлом
-      if (current_node->right) {
-        current_node = current_node->right;
+      if (nodes.right[current_node] != NodeArena::kNone) {
+        current_node = nodes.right[current_node];
       // Иначе, если правого ребенка нет, создаем новый узел
       } else {
-        current_node->right = new TreeNode(value);
+        uint32_t new_node = nodes.Create(value);
+        nodes.right[current_node] = new_node;
+        height = std::max(height, depth);
         return;
       }
     }
@@ -141,18 +512,75 @@ void Tree::Add(int value) {
 }
 
 
+// Родитель нового узла при наивной вставке - его ближайший сосед
+// по порядку среди уже вставленных: предшественник или преемник,
+// тот из них, который вставлен позже (он лежит глубже другого).
+// Равные значения уходят вправо, поэтому среди равных новый ключ
+// считается наибольшим: ключи сравниваются парой (значение, номер вставки).
+void Tree::BuildFromSequence(const std::vector<int>& values) {
+  nodes.Reserve(nodes.Size() + values.size());
+  // Номер узла в хранилище совпадает с порядком вставки
+  std::set<std::pair<int, uint32_t>> inserted;
+  for (uint32_t node = 0; node < nodes.Size(); node++) {
+    inserted.emplace(nodes.value[node], node);
+  }
+  // Глубины узлов для подсчета высоты. Родитель вставлен раньше
+  // ребенка, поэтому для уже вставленных узлов хватает прохода по номерам.
+  std::vector<uint32_t> depth(nodes.Size() + values.size(), 1);
+  for (uint32_t node = 0; node < nodes.Size(); node++) {
+    if (nodes.left[node] != NodeArena::kNone) {
+      depth[nodes.left[node]] = depth[node] + 1;
+    }
+    if (nodes.right[node] != NodeArena::kNone) {
+      depth[nodes.right[node]] = depth[node] + 1;
+    }
+  }
+  for (int value : values) {
+    uint32_t new_node = nodes.Create(value);
+    if (root == NodeArena::kNone) {
+      root = new_node;
+      height = 1;
+      inserted.emplace(value, new_node);
+      continue;
+    }
+    // Преемник - первый ключ со значением больше value,
+    // предшественник - последний со значением не больше value
+    auto successor = inserted.upper_bound(
+        std::make_pair(value, NodeArena::kNone));
+    bool has_successor = successor != inserted.end();
+    bool has_predecessor = successor != inserted.begin();
+    if (has_predecessor &&
+        (!has_successor || std::prev(successor)->second > successor->second)) {
+      uint32_t parent = std::prev(successor)->second;
+      assert(nodes.right[parent] == NodeArena::kNone);
+      nodes.right[parent] = new_node;
+      depth[new_node] = depth[parent] + 1;
+    } else {
+      uint32_t parent = successor->second;
+      assert(nodes.left[parent] == NodeArena::kNone);
+      nodes.left[parent] = new_node;
+      depth[new_node] = depth[parent] + 1;
+    }
+    height = std::max(height, depth[new_node]);
+    inserted.emplace_hint(successor, value, new_node);
+  }
+}
+
+
 int main() {
   int n = 0;
   std::cin >> n;
-  Tree tree;
-  int inp = 0;
+  std::vector<int> values(n);
   for (int i = 0; i < n; i++) {
-    std::cin >> inp;
-    tree.Add(inp);
+    std::cin >> values[i];
   }
+  Tree tree;
+  tree.BuildFromSequence(values);
 
-  for (auto node : tree.PreOrderTraverse()) {
-    std::cout << node->value << " ";
+  FdWriter writer(STDOUT_FILENO);
+  for (int value : tree.Traverse(TraverseOrder::kPreOrder)) {
+    writer.WriteInt(value);
+    writer.WriteChar(' ');
   }
 
   return 0;
@@ -43,9 +43,13 @@ out:
 */
 
 #include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <stack>
 #include <utility>
+#include <vector>
 
 // Узел бинарного дерева
 struct SplayTreeNode {
@@ -69,6 +73,11 @@ class SplayTree {
   int AddReturnPlace(int value);
   // Удаляет солдата с места k
   void RemovePlace(int k);
+  // Добавляет пачку солдат разного роста, отсортированную по возрастанию,
+  // возвращает их места в строю после добавления всей пачки
+  std::vector<int> AddSorted(const int* values, int count);
+  // Удаляет солдат с мест [from, to), возвращает их роста в порядке строя
+  std::vector<int> RemovePlaces(int from, int to);
 
  private:
   void Splay(SplayTreeNode* node);
@@ -80,16 +89,32 @@ class SplayTree {
   int GetCount(SplayTreeNode* node);
   void FixCount(SplayTreeNode* node);
   SplayTreeNode* FindPlace(int k);
+  // Поиск k-го по возрастанию узла в поддереве (с единицы)
+  SplayTreeNode* FindRank(SplayTreeNode* tree, int k);
+  // Разделение поддерева на узлы меньше value и остальные
+  std::pair<SplayTreeNode*, SplayTreeNode*> SplitByValue(SplayTreeNode* tree,
+                                                         int value);
+  // Разделение поддерева на k наименьших узлов и остальные
+  std::pair<SplayTreeNode*, SplayTreeNode*> SplitByRank(SplayTreeNode* tree,
+                                                        int k);
+  // Строит сбалансированное дерево из отсортированного массива
+  static SplayTreeNode* BuildBalanced(const int* values, int count);
+  static void DeleteSubtree(SplayTreeNode* node);
 
   SplayTreeNode* root = nullptr;
 };
 
 
 SplayTree::~SplayTree() {
-  if (!root) return;
+  DeleteSubtree(root);
+}
+
+
+void SplayTree::DeleteSubtree(SplayTreeNode* node) {
+  if (!node) return;
   std::stack<SplayTreeNode*> next_nodes;
-  // Добавляем корень на стек
-  next_nodes.push(root);
+  // Добавляем корень поддерева на стек
+  next_nodes.push(node);
   SplayTreeNode* current_node = nullptr;
   // Удаляем узлы, пока стек не опустеет
   while (!next_nodes.empty()) {
@@ -205,11 +230,15 @@ void SplayTree::RemovePlace(int k) {
 SplayTreeNode* SplayTree::FindPlace(int k) {
   // Т.к. солдат расставляют по убыванию роста,
   // ищем (n-k)-ую порядковую статистику.
-  k = (root->count) - (k);
-  // Проверка, что солдат k в строю
-  assert((k >= 0) && (k <= root->count));
+  return FindRank(root, root->count - k);
+}
+
+
+SplayTreeNode* SplayTree::FindRank(SplayTreeNode* tree, int k) {
+  // Проверка, что узел k в поддереве
+  assert((k >= 0) && (k <= tree->count));
   int left_count = 0;
-  SplayTreeNode* current_node = root;
+  SplayTreeNode* current_node = tree;
   while (k > 0) {
     left_count = GetCount(current_node->left);
     // Если в левом поддереве узлов больше, чем k,
@@ -230,6 +259,161 @@ SplayTreeNode* SplayTree::FindPlace(int k) {
 }
 
 
+// Разделение поддерева по значению: слева узлы меньше value
+std::pair<SplayTreeNode*, SplayTreeNode*> SplayTree::SplitByValue(
+    SplayTreeNode* tree, int value) {
+  if (!tree) return std::make_pair(nullptr, nullptr);
+  // Ищем последний узел на пути поиска value и поднимаем его
+  SplayTreeNode* current_node = tree;
+  SplayTreeNode* last_node = nullptr;
+  while (current_node) {
+    last_node = current_node;
+    current_node = value < current_node->value ? current_node->left
+                                               : current_node->right;
+  }
+  Splay(last_node);
+  // Отрезаем от поднятого узла одно из поддеревьев
+  if (last_node->value < value) {
+    SplayTreeNode* _right = last_node->right;
+    last_node->right = nullptr;
+    if (_right) {
+      _right->parent = nullptr;
+    }
+    last_node->count = GetCount(last_node->left) + 1;
+    return std::make_pair(last_node, _right);
+  }
+  SplayTreeNode* _left = last_node->left;
+  last_node->left = nullptr;
+  if (_left) {
+    _left->parent = nullptr;
+  }
+  last_node->count = GetCount(last_node->right) + 1;
+  return std::make_pair(_left, last_node);
+}
+
+
+// Разделение поддерева по порядку: слева k наименьших узлов
+std::pair<SplayTreeNode*, SplayTreeNode*> SplayTree::SplitByRank(
+    SplayTreeNode* tree, int k) {
+  if (k == 0) return std::make_pair(nullptr, tree);
+  if (k == tree->count) return std::make_pair(tree, nullptr);
+  // Поднимаем k-ый узел, справа от него остаются большие
+  SplayTreeNode* node = FindRank(tree, k);
+  Splay(node);
+  SplayTreeNode* _right = node->right;
+  node->right = nullptr;
+  _right->parent = nullptr;
+  node->count = GetCount(node->left) + 1;
+  return std::make_pair(node, _right);
+}
+
+
+// Построение сбалансированного дерева без рекурсии:
+// на стеке лежат еще не построенные отрезки массива
+SplayTreeNode* SplayTree::BuildBalanced(const int* values, int count) {
+  struct Segment {
+    int begin;
+    int end;
+    SplayTreeNode* parent;
+    bool is_left;
+  };
+  SplayTreeNode* result = nullptr;
+  std::stack<Segment> segments;
+  segments.push(Segment{0, count, nullptr, false});
+  while (!segments.empty()) {
+    Segment segment = segments.top();
+    segments.pop();
+    if (segment.begin == segment.end) continue;
+    // Середина отрезка становится корнем поддерева
+    int middle = segment.begin + (segment.end - segment.begin) / 2;
+    SplayTreeNode* node = new SplayTreeNode(values[middle]);
+    node->count = segment.end - segment.begin;
+    node->parent = segment.parent;
+    if (!segment.parent) {
+      result = node;
+    } else if (segment.is_left) {
+      segment.parent->left = node;
+    } else {
+      segment.parent->right = node;
+    }
+    segments.push(Segment{segment.begin, middle, node, true});
+    segments.push(Segment{middle + 1, segment.end, node, false});
+  }
+  return result;
+}
+
+
+// Добавление пачки: разрезаем дерево в промежутках между существующими
+// узлами, куда попадают новые роста, каждую серию подряд идущих ростов
+// строим сразу сбалансированным поддеревом и приклеиваем слиянием
+std::vector<int> SplayTree::AddSorted(const int* values, int count) {
+  int total = GetCount(root) + count;
+  std::vector<int> places(count);
+  // Уже собранная часть строя: все, что меньше текущего роста
+  SplayTreeNode* assembled = nullptr;
+  SplayTreeNode* rest = root;
+  int i = 0;
+  while (i < count) {
+    assert((i == 0) || (values[i - 1] < values[i]));
+    std::pair<SplayTreeNode*, SplayTreeNode*> parts =
+        SplitByValue(rest, values[i]);
+    assembled = Merge(assembled, parts.first);
+    rest = parts.second;
+    // Серия заканчивается перед наименьшим из оставшихся узлов
+    int run_end = count;
+    if (rest) {
+      while (rest->left) {
+        rest = rest->left;
+      }
+      Splay(rest);
+      run_end = static_cast<int>(
+          std::lower_bound(values + i, values + count, rest->value) - values);
+    }
+    // Под нашими ростами больше ничего не добавится, места окончательные
+    int below = GetCount(assembled);
+    for (int j = i; j < run_end; j++) {
+      places[j] = total - 1 - (below + j - i);
+    }
+    assembled = Merge(assembled, BuildBalanced(values + i, run_end - i));
+    i = run_end;
+  }
+  root = Merge(assembled, rest);
+  return places;
+}
+
+
+// Удаление отрезка мест двумя разрезами по порядку
+std::vector<int> SplayTree::RemovePlaces(int from, int to) {
+  int total = GetCount(root);
+  // Проверка, что все солдаты в строю
+  assert((0 <= from) && (from <= to) && (to <= total));
+  // Места [from, to) по убыванию - это узлы [total - to, total - from)
+  // по возрастанию
+  std::pair<SplayTreeNode*, SplayTreeNode*> head =
+      SplitByRank(root, total - to);
+  std::pair<SplayTreeNode*, SplayTreeNode*> middle =
+      SplitByRank(head.second, to - from);
+  // Собираем роста вырезанного поддерева по убыванию
+  std::vector<int> heights;
+  heights.reserve(to - from);
+  std::stack<SplayTreeNode*> next_nodes;
+  SplayTreeNode* current_node = middle.first;
+  while (current_node || !next_nodes.empty()) {
+    while (current_node) {
+      next_nodes.push(current_node);
+      current_node = current_node->right;
+    }
+    current_node = next_nodes.top();
+    next_nodes.pop();
+    heights.push_back(current_node->value);
+    current_node = current_node->left;
+  }
+  DeleteSubtree(middle.first);
+  root = Merge(head.first, middle.second);
+  return heights;
+}
+
+
 // Слияние двух деревьев 
 SplayTreeNode* SplayTree::Merge(SplayTreeNode* _left, SplayTreeNode* _right) {
   // Если есть левое поддерево
@@ -246,6 +430,8 @@ SplayTreeNode* SplayTree::Merge(SplayTreeNode* _left, SplayTreeNode* _right) {
     if (_right) {
       _right->parent = _left;
     }
+    // Правим количество узлов с учетом правого поддерева
+    _left->count = GetCount(_left->left) + GetCount(_right) + 1;
     return _left;
   // Если левого поддерева нет, возвращаем правое
   } else {
@@ -368,10 +554,730 @@ void SplayTree::FixCount(SplayTreeNode* node) {
   }
 }
 
+// Строй на дереве Фенвика по ростам 1..kMaxHeight.
+// Рост ограничен, поэтому вместо узлов храним количество
+// солдат каждого роста: место - это число более высоких солдат,
+// а удаление по месту - поиск порядковой статистики спуском по степеням двойки.
+// Память выделяется один раз, все операции O(log H)
+class FenwickSoldierLine {
+ public:
+  FenwickSoldierLine() : tree(kMaxHeight + 1, 0) {}
+
+  // Добавляет солдата, возвращает его место
+  int AddReturnPlace(int value);
+  // Удаляет солдата с места k
+  void RemovePlace(int k);
+
+ private:
+  static const int kMaxHeight = 100000;
+  // Старшая степень двойки, не превосходящая kMaxHeight
+  static const int kTopBit = 1 << 16;
+
+  void Update(int index, int delta);
+  // Количество солдат с ростом не выше index
+  int Prefix(int index) const;
+  // Рост rank-го по возрастанию солдата (с единицы)
+  int Select(int rank) const;
+
+  std::vector<int> tree;
+  int count = 0;
+};
+
+
+int FenwickSoldierLine::AddReturnPlace(int value) {
+  assert((value >= 1) && (value <= kMaxHeight));
+  // Все роста разные, поэтому перед солдатом стоят все, кто выше
+  int place = count - Prefix(value);
+  Update(value, 1);
+  count++;
+  return place;
+}
+
+
+void FenwickSoldierLine::RemovePlace(int k) {
+  // Проверка, что солдат k в строю
+  assert((k >= 0) && (k < count));
+  // Строй по убыванию роста, поэтому место k - это
+  // (count - k)-ый солдат по возрастанию
+  Update(Select(count - k), -1);
+  count--;
+}
+
+
+void FenwickSoldierLine::Update(int index, int delta) {
+  for (; index <= kMaxHeight; index += index & -index) {
+    tree[index] += delta;
+  }
+}
+
+
+int FenwickSoldierLine::Prefix(int index) const {
+  int result = 0;
+  for (; index > 0; index -= index & -index) {
+    result += tree[index];
+  }
+  return result;
+}
+
+
+int FenwickSoldierLine::Select(int rank) const {
+  int position = 0;
+  // Спускаемся по степеням двойки, пока префикс меньше rank
+  for (int step = kTopBit; step > 0; step >>= 1) {
+    int next = position + step;
+    if (next <= kMaxHeight && tree[next] < rank) {
+      position = next;
+      rank -= tree[next];
+    }
+  }
+  return position + 1;
+}
+
+
+// Узел сплей дерева в пуле: вместо указателей 32-битные индексы,
+// ссылки на родителя не нужны, 16 байт вместо 40
+struct PooledSplayNode {
+  int value = 0;
+  uint32_t count = 1;
+  uint32_t left = 0;
+  uint32_t right = 0;
+};
+
+
+// Сплей дерево с нисходящим splay (по Слейтору) и подсчетом размеров
+// поддеревьев. Узлы лежат в одном векторе, освободившиеся
+// собираются в список через поле left и используются повторно
+class TopDownSplayTree {
+ public:
+  TopDownSplayTree();
+
+  // Добавляет солдата, возвращает его место
+  int AddReturnPlace(int value);
+  // Удаляет солдата с места k
+  void RemovePlace(int k);
+
+ private:
+  static const uint32_t kNone = UINT32_MAX;
+  // Узел 0 - заголовок для сборки левого и правого деревьев при splay
+  static const uint32_t kHeader = 0;
+
+  uint32_t NewNode(int value);
+  void FreeNode(uint32_t node);
+  uint32_t GetCount(uint32_t node) const;
+  void FixCount(uint32_t node);
+  // Поднимает в корень узел со значением value или последний узел
+  // на пути поиска, возвращает новый корень
+  uint32_t SplayByValue(uint32_t node, int value);
+  // Поднимает в корень rank-ый по возрастанию узел (с нуля)
+  uint32_t SplayByRank(uint32_t node, uint32_t rank);
+  // Собирает дерево после нисходящего прохода: left_tail и right_tail -
+  // последние узлы левого и правого деревьев, left_count и right_count - их размеры
+  uint32_t Assemble(uint32_t node, uint32_t left_tail, uint32_t right_tail,
+                    uint32_t left_count, uint32_t right_count);
+
+  std::vector<PooledSplayNode> nodes;
+  uint32_t free_list = kNone;
+  uint32_t root = kNone;
+};
+
+
+TopDownSplayTree::TopDownSplayTree() : nodes(1) {}
+
+
+uint32_t TopDownSplayTree::NewNode(int value) {
+  uint32_t node = free_list;
+  if (node != kNone) {
+    free_list = nodes[node].left;
+  } else {
+    node = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+  }
+  nodes[node].value = value;
+  nodes[node].count = 1;
+  nodes[node].left = kNone;
+  nodes[node].right = kNone;
+  return node;
+}
+
+
+void TopDownSplayTree::FreeNode(uint32_t node) {
+  nodes[node].left = free_list;
+  free_list = node;
+}
+
+
+uint32_t TopDownSplayTree::GetCount(uint32_t node) const {
+  return node == kNone ? 0 : nodes[node].count;
+}
+
+
+void TopDownSplayTree::FixCount(uint32_t node) {
+  nodes[node].count =
+      GetCount(nodes[node].left) + GetCount(nodes[node].right) + 1;
+}
+
+
+uint32_t TopDownSplayTree::SplayByValue(uint32_t node, int value) {
+  nodes[kHeader].left = nodes[kHeader].right = kNone;
+  uint32_t left_tail = kHeader;
+  uint32_t right_tail = kHeader;
+  uint32_t left_count = 0;
+  uint32_t right_count = 0;
+  while (true) {
+    if (value < nodes[node].value) {
+      uint32_t child = nodes[node].left;
+      if (child == kNone) break;
+      if (value < nodes[child].value) {
+        // Поворот направо
+        nodes[node].left = nodes[child].right;
+        nodes[child].right = node;
+        FixCount(node);
+        node = child;
+        if (nodes[node].left == kNone) break;
+      }
+      // Узел со всем правым поддеревом уходит в правое дерево
+      nodes[right_tail].left = node;
+      right_tail = node;
+      right_count += 1 + GetCount(nodes[node].right);
+      node = nodes[node].left;
+    } else if (value > nodes[node].value) {
+      uint32_t child = nodes[node].right;
+      if (child == kNone) break;
+      if (value > nodes[child].value) {
+        // Поворот налево
+        nodes[node].right = nodes[child].left;
+        nodes[child].left = node;
+        FixCount(node);
+        node = child;
+        if (nodes[node].right == kNone) break;
+      }
+      // Узел со всем левым поддеревом уходит в левое дерево
+      nodes[left_tail].right = node;
+      left_tail = node;
+      left_count += 1 + GetCount(nodes[node].left);
+      node = nodes[node].right;
+    } else {
+      break;
+    }
+  }
+  return Assemble(node, left_tail, right_tail, left_count, right_count);
+}
+
+
+uint32_t TopDownSplayTree::SplayByRank(uint32_t node, uint32_t rank) {
+  assert(rank < GetCount(node));
+  nodes[kHeader].left = nodes[kHeader].right = kNone;
+  uint32_t left_tail = kHeader;
+  uint32_t right_tail = kHeader;
+  uint32_t left_count = 0;
+  uint32_t right_count = 0;
+  // rank всегда отсчитывается внутри поддерева текущего узла
+  while (true) {
+    uint32_t node_left_count = GetCount(nodes[node].left);
+    if (rank < node_left_count) {
+      uint32_t child = nodes[node].left;
+      if (rank < GetCount(nodes[child].left)) {
+        // Поворот направо, ранг внутри нового корня не меняется
+        nodes[node].left = nodes[child].right;
+        nodes[child].right = node;
+        FixCount(node);
+        node = child;
+      }
+      nodes[right_tail].left = node;
+      right_tail = node;
+      right_count += 1 + GetCount(nodes[node].right);
+      node = nodes[node].left;
+    } else if (rank > node_left_count) {
+      uint32_t child = nodes[node].right;
+      rank -= node_left_count + 1;
+      uint32_t child_left_count = GetCount(nodes[child].left);
+      if (rank > child_left_count) {
+        // Поворот налево, дальше спускаемся в правое поддерево child
+        nodes[node].right = nodes[child].left;
+        nodes[child].left = node;
+        FixCount(node);
+        node = child;
+        rank -= child_left_count + 1;
+      }
+      nodes[left_tail].right = node;
+      left_tail = node;
+      left_count += 1 + GetCount(nodes[node].left);
+      node = nodes[node].right;
+    } else {
+      break;
+    }
+  }
+  return Assemble(node, left_tail, right_tail, left_count, right_count);
+}
+
+
+uint32_t TopDownSplayTree::Assemble(uint32_t node, uint32_t left_tail,
+                                    uint32_t right_tail, uint32_t left_count,
+                                    uint32_t right_count) {
+  left_count += GetCount(nodes[node].left);
+  right_count += GetCount(nodes[node].right);
+  nodes[node].count = left_count + right_count + 1;
+  nodes[left_tail].right = kNone;
+  nodes[right_tail].left = kNone;
+  // При спуске размеры узлов на правом краю левого дерева и на левом
+  // краю правого дерева не знали, что будет подвешено ниже. Правим их сверху вниз
+  for (uint32_t current = nodes[kHeader].right; current != kNone;
+       current = nodes[current].right) {
+    nodes[current].count = left_count;
+    left_count -= 1 + GetCount(nodes[current].left);
+  }
+  for (uint32_t current = nodes[kHeader].left; current != kNone;
+       current = nodes[current].left) {
+    nodes[current].count = right_count;
+    right_count -= 1 + GetCount(nodes[current].right);
+  }
+  // Подвешиваем детей узла к краям и сам узел делаем корнем
+  nodes[left_tail].right = nodes[node].left;
+  nodes[right_tail].left = nodes[node].right;
+  nodes[node].left = nodes[kHeader].right;
+  nodes[node].right = nodes[kHeader].left;
+  return node;
+}
+
+
+int TopDownSplayTree::AddReturnPlace(int value) {
+  uint32_t node = NewNode(value);
+  if (root != kNone) {
+    root = SplayByValue(root, value);
+    // Все роста разные, новый узел встает между корнем и его поддеревом
+    if (value < nodes[root].value) {
+      nodes[node].left = nodes[root].left;
+      nodes[node].right = root;
+      nodes[root].left = kNone;
+    } else {
+      nodes[node].right = nodes[root].right;
+      nodes[node].left = root;
+      nodes[root].right = kNone;
+    }
+    FixCount(root);
+    FixCount(node);
+  }
+  root = node;
+  // Место - это количество более высоких солдат
+  return static_cast<int>(GetCount(nodes[root].right));
+}
+
+
+void TopDownSplayTree::RemovePlace(int k) {
+  uint32_t count = GetCount(root);
+  // Проверка, что солдат k в строю
+  assert((k >= 0) && (static_cast<uint32_t>(k) < count));
+  // Строй по убыванию роста
+  uint32_t node = SplayByRank(root, count - 1 - k);
+  uint32_t left = nodes[node].left;
+  uint32_t right = nodes[node].right;
+  if (left == kNone) {
+    root = right;
+  } else {
+    // Максимум левого поддерева становится корнем, правого ребенка у него нет
+    root = SplayByRank(left, GetCount(left) - 1);
+    nodes[root].right = right;
+    FixCount(root);
+  }
+  FreeNode(node);
+}
+
+
+// Узел неизменяемого дерева. После публикации не меняется,
+// поэтому может входить сразу в несколько версий дерева
+struct PersistentNode {
+  PersistentNode(int _value, const PersistentNode* _left,
+                 const PersistentNode* _right);
+
+  int value = 0;
+  int count = 1;
+  const PersistentNode* left = nullptr;
+  const PersistentNode* right = nullptr;
+};
+
+
+PersistentNode::PersistentNode(int _value, const PersistentNode* _left,
+                               const PersistentNode* _right)
+    : value(_value), left(_left), right(_right) {
+  count = 1 + (left ? left->count : 0) + (right ? right->count : 0);
+}
+
+
+// Размер кэш-линии: ячейки читателей не должны делить одну линию
+constexpr size_t kCacheLineSize = 64;
+
+// Строй для чтения из многих потоков одновременно с одним писателем.
+// Дерево сбалансировано по весу и не перестраивается при чтении.
+// Писатель не меняет узлы, а копирует путь от корня и атомарно
+// публикует новый корень. Замененные узлы освобождаются по эпохам:
+// читатель перед спуском записывает текущую эпоху в свою ячейку,
+// и узел, снятый в эпоху e, удаляется, когда ни в одной ячейке
+// не осталось эпохи <= e. Читатель пишет только в свою ячейку
+// на отдельной кэш-линии и не трогает счетчики ссылок,
+// поэтому чтения из разных потоков не мешают друг другу
+class SnapshotSoldierLine {
+ public:
+  // Наибольшее число потоков-читателей
+  static const int kMaxReaders = 64;
+
+  SnapshotSoldierLine() = default;
+  // Читателей в этот момент быть не должно
+  ~SnapshotSoldierLine();
+  SnapshotSoldierLine(const SnapshotSoldierLine&) = delete;
+  SnapshotSoldierLine& operator=(const SnapshotSoldierLine&) = delete;
+
+  // Писатель: вызывать только из одного потока
+  // Добавляет солдата, возвращает его место
+  int AddReturnPlace(int value);
+  // Удаляет солдата с места k
+  void RemovePlace(int k);
+
+  // Читатели: можно вызывать из любых потоков.
+  // Каждый поток-читатель один раз получает свой номер
+  int RegisterReader() const;
+
+  // Снимок текущей версии строя. Пока снимок жив, его узлы
+  // не освобождаются. У читателя одновременно не больше одного снимка
+  class ReadGuard {
+   public:
+    ReadGuard(const SnapshotSoldierLine& line, int reader);
+    ~ReadGuard();
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    const PersistentNode* Root() const { return root; }
+
+   private:
+    std::atomic<uint64_t>* slot;
+    const PersistentNode* root;
+  };
+
+  // Место солдата с ростом value в снимке или -1, если его нет в строю
+  static int PlaceOf(const PersistentNode* snapshot, int value);
+  // Рост солдата на месте place в снимке или -1, если места нет
+  static int HeightAt(const PersistentNode* snapshot, int place);
+  int PlaceOf(int reader, int value) const {
+    ReadGuard guard(*this, reader);
+    return PlaceOf(guard.Root(), value);
+  }
+  int HeightAt(int reader, int place) const {
+    ReadGuard guard(*this, reader);
+    return HeightAt(guard.Root(), place);
+  }
+
+ private:
+  // Шаг пути от корня: узел и направление спуска из него
+  struct PathStep {
+    const PersistentNode* node;
+    bool went_left;
+  };
+
+  // Ячейка читателя: эпоха, в которую он взял снимок,
+  // или kIdle, если снимка нет
+  struct alignas(kCacheLineSize) ReaderSlot {
+    std::atomic<uint64_t> epoch{kIdle};
+  };
+
+  // Узел, снятый писателем, и эпоха, в которую это случилось
+  struct RetiredNode {
+    uint64_t epoch;
+    const PersistentNode* node;
+  };
+
+  // Вес поддерева - размер + 1. Вес одного ребенка превышает вес другого
+  // не более чем в kDelta раз, kRatio выбирает одинарный или двойной поворот
+  static const int kDelta = 3;
+  static const int kRatio = 2;
+  static const uint64_t kIdle = UINT64_MAX;
+  // Ячейки читателей просматриваются не чаще, чем раз на столько снятых узлов
+  static const size_t kReclaimBatch = 1024;
+
+  static int GetCount(const PersistentNode* node);
+  static const PersistentNode* MakeNode(int value, const PersistentNode* left,
+                                        const PersistentNode* right);
+  // Новый узел с восстановлением баланса
+  const PersistentNode* Balance(int value, const PersistentNode* left,
+                                const PersistentNode* right);
+  // Копирует путь снизу вверх, подвешивая subtree вместо последнего шага
+  const PersistentNode* RebuildPath(const std::vector<PathStep>& path,
+                                    const PersistentNode* subtree);
+  // Копия поддерева без минимального узла, его значение в min_value
+  const PersistentNode* RemoveMin(const PersistentNode* node, int* min_value);
+  // Узел больше не входит в новую версию
+  void Retire(const PersistentNode* node);
+  // Публикует новый корень и помечает снятые узлы текущей эпохой
+  void Publish(const PersistentNode* new_root);
+  // Освобождает узлы, которые не видит ни один читатель
+  void Reclaim();
+
+  std::atomic<const PersistentNode*> root{nullptr};
+  alignas(kCacheLineSize) std::atomic<uint64_t> epoch{1};
+  // Ячейки меняются читателями, строй для них при этом не меняется
+  mutable std::atomic<int> readers_count{0};
+  mutable ReaderSlot readers[kMaxReaders];
+  // Дальше только для писателя
+  std::vector<const PersistentNode*> pending;
+  std::vector<RetiredNode> retired;
+};
+
+
+const uint64_t SnapshotSoldierLine::kIdle;
+const size_t SnapshotSoldierLine::kReclaimBatch;
+
+
+SnapshotSoldierLine::~SnapshotSoldierLine() {
+  std::stack<const PersistentNode*> nodes;
+  if (root.load()) nodes.push(root.load());
+  while (!nodes.empty()) {
+    const PersistentNode* node = nodes.top();
+    nodes.pop();
+    if (node->left) nodes.push(node->left);
+    if (node->right) nodes.push(node->right);
+    delete node;
+  }
+  for (const RetiredNode& retired_node : retired) {
+    delete retired_node.node;
+  }
+}
+
+
+int SnapshotSoldierLine::RegisterReader() const {
+  int reader = readers_count.fetch_add(1);
+  assert(reader < kMaxReaders);
+  return reader;
+}
+
+
+SnapshotSoldierLine::ReadGuard::ReadGuard(const SnapshotSoldierLine& line,
+                                          int reader)
+    : slot(&line.readers[reader].epoch) {
+  // Эпоха объявляется до чтения корня. Если писатель уже просмотрел
+  // ячейки и не увидел ее, то корень прочитается уже новый
+  slot->store(line.epoch.load());
+  root = line.root.load();
+}
+
+
+SnapshotSoldierLine::ReadGuard::~ReadGuard() {
+  slot->store(kIdle, std::memory_order_release);
+}
+
+
+int SnapshotSoldierLine::GetCount(const PersistentNode* node) {
+  return node ? node->count : 0;
+}
+
+
+const PersistentNode* SnapshotSoldierLine::MakeNode(
+    int value, const PersistentNode* left, const PersistentNode* right) {
+  return new PersistentNode(value, left, right);
+}
+
+
+const PersistentNode* SnapshotSoldierLine::Balance(
+    int value, const PersistentNode* left, const PersistentNode* right) {
+  int left_weight = GetCount(left) + 1;
+  int right_weight = GetCount(right) + 1;
+  if (right_weight > kDelta * left_weight) {
+    const PersistentNode* heavy = right;
+    Retire(heavy);
+    if (GetCount(heavy->left) + 1 < kRatio * (GetCount(heavy->right) + 1)) {
+      // Поворот налево
+      return MakeNode(heavy->value, MakeNode(value, left, heavy->left),
+                      heavy->right);
+    }
+    // Двойной поворот: внук становится корнем
+    const PersistentNode* middle = heavy->left;
+    Retire(middle);
+    return MakeNode(middle->value, MakeNode(value, left, middle->left),
+                    MakeNode(heavy->value, middle->right, heavy->right));
+  }
+  if (left_weight > kDelta * right_weight) {
+    const PersistentNode* heavy = left;
+    Retire(heavy);
+    if (GetCount(heavy->right) + 1 < kRatio * (GetCount(heavy->left) + 1)) {
+      // Поворот направо
+      return MakeNode(heavy->value, heavy->left,
+                      MakeNode(value, heavy->right, right));
+    }
+    const PersistentNode* middle = heavy->right;
+    Retire(middle);
+    return MakeNode(middle->value, MakeNode(heavy->value, heavy->left,
+                                            middle->left),
+                    MakeNode(value, middle->right, right));
+  }
+  return MakeNode(value, left, right);
+}
+
+
+const PersistentNode* SnapshotSoldierLine::RebuildPath(
+    const std::vector<PathStep>& path, const PersistentNode* subtree) {
+  for (auto step = path.rbegin(); step != path.rend(); ++step) {
+    const PersistentNode* node = step->node;
+    Retire(node);
+    subtree = step->went_left ? Balance(node->value, subtree, node->right)
+                              : Balance(node->value, node->left, subtree);
+  }
+  return subtree;
+}
+
+
+const PersistentNode* SnapshotSoldierLine::RemoveMin(
+    const PersistentNode* node, int* min_value) {
+  std::vector<PathStep> path;
+  while (node->left) {
+    path.push_back(PathStep{node, true});
+    node = node->left;
+  }
+  *min_value = node->value;
+  Retire(node);
+  return RebuildPath(path, node->right);
+}
+
+
+void SnapshotSoldierLine::Retire(const PersistentNode* node) {
+  pending.push_back(node);
+}
+
+
+void SnapshotSoldierLine::Publish(const PersistentNode* new_root) {
+  root.store(new_root);
+  // Читатель, увидевший эпоху после увеличения, видит и новый корень
+  uint64_t retired_epoch = epoch.fetch_add(1);
+  for (const PersistentNode* node : pending) {
+    retired.push_back(RetiredNode{retired_epoch, node});
+  }
+  pending.clear();
+  if (retired.size() >= kReclaimBatch) Reclaim();
+}
+
+
+void SnapshotSoldierLine::Reclaim() {
+  uint64_t oldest = kIdle;
+  for (const ReaderSlot& slot : readers) {
+    oldest = std::min(oldest, slot.epoch.load());
+  }
+  size_t kept = 0;
+  for (const RetiredNode& retired_node : retired) {
+    if (retired_node.epoch < oldest) {
+      delete retired_node.node;
+    } else {
+      retired[kept++] = retired_node;
+    }
+  }
+  retired.resize(kept);
+}
+
+
+int SnapshotSoldierLine::AddReturnPlace(int value) {
+  std::vector<PathStep> path;
+  int place = 0;
+  const PersistentNode* node = root.load(std::memory_order_relaxed);
+  while (node) {
+    bool go_left = value < node->value;
+    // Уходя влево, оставляем позади более высоких солдат
+    if (go_left) {
+      place += GetCount(node->right) + 1;
+    }
+    path.push_back(PathStep{node, go_left});
+    node = go_left ? node->left : node->right;
+  }
+  Publish(RebuildPath(path, MakeNode(value, nullptr, nullptr)));
+  return place;
+}
+
+
+void SnapshotSoldierLine::RemovePlace(int k) {
+  const PersistentNode* current = root.load(std::memory_order_relaxed);
+  // Проверка, что солдат k в строю
+  assert((k >= 0) && (k < GetCount(current)));
+  // Строй по убыванию роста, ищем узел по порядку возрастания
+  int rank = GetCount(current) - 1 - k;
+  std::vector<PathStep> path;
+  const PersistentNode* node = current;
+  while (true) {
+    int left_count = GetCount(node->left);
+    if (rank < left_count) {
+      path.push_back(PathStep{node, true});
+      node = node->left;
+    } else if (rank > left_count) {
+      rank -= left_count + 1;
+      path.push_back(PathStep{node, false});
+      node = node->right;
+    } else {
+      break;
+    }
+  }
+  Retire(node);
+  // На место удаляемого узла встает минимум правого поддерева
+  const PersistentNode* subtree = nullptr;
+  if (!node->left) {
+    subtree = node->right;
+  } else if (!node->right) {
+    subtree = node->left;
+  } else {
+    int min_value = 0;
+    const PersistentNode* right = RemoveMin(node->right, &min_value);
+    subtree = Balance(min_value, node->left, right);
+  }
+  Publish(RebuildPath(path, subtree));
+}
+
+
+int SnapshotSoldierLine::PlaceOf(const PersistentNode* snapshot, int value) {
+  int place = 0;
+  const PersistentNode* node = snapshot;
+  while (node) {
+    if (value < node->value) {
+      place += GetCount(node->right) + 1;
+      node = node->left;
+    } else if (value > node->value) {
+      node = node->right;
+    } else {
+      return place + GetCount(node->right);
+    }
+  }
+  return -1;
+}
+
+
+int SnapshotSoldierLine::HeightAt(const PersistentNode* snapshot, int place) {
+  if ((place < 0) || (place >= GetCount(snapshot))) return -1;
+  int rank = GetCount(snapshot) - 1 - place;
+  const PersistentNode* node = snapshot;
+  while (true) {
+    int left_count = GetCount(node->left);
+    if (rank < left_count) {
+      node = node->left;
+    } else if (rank > left_count) {
+      rank -= left_count + 1;
+      node = node->right;
+    } else {
+      return node->value;
+    }
+  }
+}
+
+
+// Реализация строя выбирается при сборке:
+// -DSOLDIER_LINE_FENWICK - дерево Фенвика по ростам,
+// -DSOLDIER_LINE_TOP_DOWN - нисходящее сплей дерево на пуле узлов,
+// -DSOLDIER_LINE_SNAPSHOT - персистентное дерево для многопоточного чтения,
+// по умолчанию - сплей дерево
+#ifdef SOLDIER_LINE_FENWICK
+using SoldierLine = FenwickSoldierLine;
+#elif defined(SOLDIER_LINE_TOP_DOWN)
+using SoldierLine = TopDownSplayTree;
+#elif defined(SOLDIER_LINE_SNAPSHOT)
+using SoldierLine = SnapshotSoldierLine;
+#else
+using SoldierLine = SplayTree;
+#endif
+
 int main() {
     int n = 0;
     std::cin >> n;
-    SplayTree tree;
+    SoldierLine tree;
     int cmd = 0;
     int inp = 0;
     for (int i = 0; i < n; i++) {
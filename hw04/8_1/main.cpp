@@ -54,116 +54,202 @@ OK
 */
 
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
+
+// Хеш-таблица в раскладке SwissTable: ключи лежат отдельно от
+// управляющих байтов, а управляющие байты разбиты на группы по 16.
+// Байт занятого слота хранит 7 бит хеша ключа, поэтому группу
+// проверяем одним SSE2 сравнением, а строки сравниваем только
+// при совпадении этих 7 бит. Короткие ключи лежат прямо в слотах,
+// длинные - в общем буфере, и при перехешировании переносятся
+// только слоты фиксированного размера
 class HashTable {
  public:
-  explicit HashTable(size_t initial_size);
+  // Смещение в буфере 40-битное: 4 байта слота и еще один из свободных
+  static const uint64_t kMaxArenaSize = 1ULL << 40;
+
+  // max_arena_size - предел буфера длинных ключей, меньше kMaxArenaSize
+  // он бывает только в проверках
+  explicit HashTable(size_t initial_size,
+                     uint64_t _max_arena_size = kMaxArenaSize);
+  // Количество ключей в таблице
+  int Size() const { return entries_number; }
   // Проверка наличия ключа в таблице
   bool Has(const std::string& key) const;
   // Добавление ключа в таблицу
   bool Add(const std::string& key);
   // Удаление ключа
   bool Remove(const std::string& key);
+  // Печать гистограмм длины пробирования (в группах)
+  // для найденных и не найденных ключей. Гистограммы ведутся только
+  // в сборке с -DHASH_TABLE_PROBE_STATS
+  void PrintProbeStats(std::ostream& out) const;
 
  private:
-  // Хеш-функция
-  int Hash(const char* str) const;
-  // Перехеширование
-  void RehashTable();
-  // Количество записей в таблице
-  int entries_number = 0;
+  static const size_t kGroupSize = 16;
+  static const size_t kNotFound = SIZE_MAX;
+  // Управляющий байт пустого и удаленного слота.
+  // У занятого слота старший бит 0, остальные - отпечаток хеша
+  static const int8_t kEmpty = -128;
+  static const int8_t kDeleted = -2;
+  // Ключи до kInlineKeySize байт хранятся в слоте
+  static const size_t kInlineKeySize = 15;
+  // Признак ключа в буфере вместо длины в последнем байте слота
+  static const uint8_t kExternalKey = 0xFF;
+  // Буфер сжимаем, когда в нем больше kCompactMinBytes мертвых байт
+  // и они занимают больше половины
+  static const size_t kCompactMinBytes = 4096;
+  // Пробирования длиннее собираем в последний столбец гистограммы
+  static const size_t kProbeHistogramSize = 16;
 
-  // Запись в таблице
-  struct HashTableEntry {
-    std::string key = "";
-    // Будем хранить сырой хеш
-    int raw_hash = 0;
-    // Флаг для используемых записей,
-    // чтобы знать, когда перестать искать повтор ключа
-    bool is_used = false;
-    // Флаг для удаленных записей
-    bool is_deleted = false;
+  // Слот ключа, 16 байт. Последний байт - длина ключа, если он
+  // лежит в слоте, или kExternalKey, тогда в начале слота ExternalKey
+  struct KeySlot {
+    char bytes[kInlineKeySize];
+    uint8_t tag;
+  };
+  // Ссылка на ключ в буфере. Хеш нужен, чтобы при перехешировании
+  // не читать ключ из буфера. В слоте лежит упакованной в 13 байт:
+  // младшие 4 байта смещения, длина, хеш и старший байт смещения
+  struct ExternalKey {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t hash;
   };
 
-  std::vector<HashTableEntry> hash_table;
+  // Хеш-функция: младшие 7 бит идут в управляющий байт,
+  // остальные выбирают группу
+  uint64_t Hash(const char* str, size_t length) const;
+  // Маска слотов группы с управляющим байтом value
+  static uint32_t MatchByte(const int8_t* group, int8_t value);
+  // Маска пустых и удаленных слотов группы
+  static uint32_t MatchFree(const int8_t* group);
+  // Хеш ключа из слота с отпечатком fingerprint без обращения к буферу
+  uint64_t SlotHash(const KeySlot& key_slot, int8_t fingerprint) const;
+  static ExternalKey ReadExternal(const KeySlot& key_slot);
+  static void WriteExternal(KeySlot* key_slot, const ExternalKey& external);
+  // Совпадает ли ключ в слоте с данным
+  bool SlotEquals(const KeySlot& key_slot, const std::string& key) const;
+  // Поиск слота с ключом, kNotFound если ключа нет
+  size_t FindSlot(const std::string& key, uint64_t hash) const;
+  // Первый пустой или удаленный слот на пути пробирования
+  size_t FindFreeSlot(uint64_t hash) const;
+  // Перехеширование в таблицу из new_groups_number групп
+  void RehashTable(size_t new_groups_number);
+  // Сжатие буфера длинных ключей
+  void CompactArena();
+
+  // Количество записей в таблице
+  int entries_number = 0;
+  // Количество удаленных слотов, они удлиняют пробирование как записи
+  int deleted_number = 0;
+  // Количество групп, степень двойки
+  size_t groups_number = 0;
+  std::vector<int8_t> control;
+  std::vector<KeySlot> keys;
+  // Буфер длинных ключей, только дописывается до сжатия
+  std::vector<char> arena;
+  // Байты удаленных ключей в буфере
+  size_t dead_bytes = 0;
+  // Предел размера буфера
+  uint64_t max_arena_size = kMaxArenaSize;
+#ifdef HASH_TABLE_PROBE_STATS
+  // Гистограммы числа просмотренных групп при поиске. Без флага поиск
+  // ничего не пишет в таблицу, и параллельные вызовы Has безопасны
+  mutable uint64_t found_probes[kProbeHistogramSize] = {};
+  mutable uint64_t missed_probes[kProbeHistogramSize] = {};
+#endif
 };
 
 
-HashTable::HashTable(size_t initial_size) : hash_table(initial_size) {}
+const size_t HashTable::kGroupSize;
+const size_t HashTable::kNotFound;
+const int8_t HashTable::kEmpty;
+const int8_t HashTable::kDeleted;
+const size_t HashTable::kInlineKeySize;
+const uint8_t HashTable::kExternalKey;
+const size_t HashTable::kCompactMinBytes;
+const uint64_t HashTable::kMaxArenaSize;
+const size_t HashTable::kProbeHistogramSize;
+
+
+HashTable::HashTable(size_t initial_size, uint64_t _max_arena_size)
+    : max_arena_size(std::min(_max_arena_size, kMaxArenaSize)) {
+  // Меньше одной группы таблица быть не может
+  groups_number = 1;
+  while (groups_number * kGroupSize < initial_size) {
+    groups_number *= 2;
+  }
+  control.assign(groups_number * kGroupSize, kEmpty);
+  keys.resize(groups_number * kGroupSize);
+}
 
 // Проверка наличия ключа
 bool HashTable::Has(const std::string& key) const {
   assert(!key.empty());
-  // Вычисляем хеш
-  int hash = Hash(&key[0]) % hash_table.size();
-
-  for (int i = 0; i < hash_table.size(); i++) {
-    // На каждой итерации обновляем пробу
-    hash = (hash + i) % hash_table.size();
-    // Если не нашли ключ и наткнулись на неиспользованную запись
-    if (!hash_table[hash].is_used) {
-      return false;
-    }
-    // Если нашли ключ и он не помечен удаленным
-    if ((hash_table[hash].key == key) && (!hash_table[hash].is_deleted)) {
-      return true;
-    }
-  }
-  // Если прошли по всем записям и не нашли, возращаем false
-  // но такого не будет, т.к. таблица динамическая
-  // с максимальным коэффициентом заполнения 0.75
-  return false;
+  return FindSlot(key, Hash(key.data(), key.size())) != kNotFound;
 }
 
 // Добавление ключа
 bool HashTable::Add(const std::string& key) {
   assert(!key.empty());
-  // Запоминаем сырой хеш для перехеширования
-  int raw_hash = Hash(&key[0]); 
-  int hash = raw_hash % hash_table.size();
-  bool found_deleted_entry = false;
-  int deleted_idx = 0;
-
-  for (int i = 0; i < hash_table.size(); i++) {
-    hash = (hash + i) % hash_table.size();
-    // Если наткнулись на неиспользованную запись, выходим из цикла
-    if (!hash_table[hash].is_used) {
-      break;
-    }
-    
-    if ((hash_table[hash].key == key) && (!hash_table[hash].is_deleted)) {
-      return false;
+  uint64_t hash = Hash(key.data(), key.size());
+  if (FindSlot(key, hash) != kNotFound) {
+    return false;
+  }
+  // Место в буфере проверяем до того, как занять слот: если ключ
+  // не помещается, таблица после исключения остается прежней
+  if (key.size() > kInlineKeySize) {
+    // Смещение в слоте 40-битное: если буфер упирается в предел,
+    // сначала выбрасываем из него удаленные ключи
+    if ((arena.size() + key.size() > max_arena_size) && (dead_bytes > 0)) {
+      CompactArena();
     }
-    // Запоминаем первую удаленную запись, чтобы переиспользовать,
-    // но из цикла не выходим, чтобы дойти до конца и проверить
-    // наличие одинаковых ключей
-    if ((hash_table[hash].is_deleted) && (!found_deleted_entry)) {
-      found_deleted_entry = true;
-      deleted_idx = hash;
+    if ((arena.size() + key.size() > max_arena_size) ||
+        (key.size() > UINT32_MAX)) {
+      throw std::length_error("HashTable: long key buffer is full");
     }
   }
-  
-  // Если встретили удаленную запись - переиспользуем ее
-  if (found_deleted_entry) {
-    hash = deleted_idx;
-    hash_table[hash].is_deleted = false;
-  // Иначе записываем в новую
+  // Ключа нет, поэтому можно занять первый свободный
+  // или удаленный слот на пути пробирования
+  size_t slot = FindFreeSlot(hash);
+  KeySlot& key_slot = keys[slot];
+  if (key.size() <= kInlineKeySize) {
+    memcpy(key_slot.bytes, key.data(), key.size());
+    key_slot.tag = static_cast<uint8_t>(key.size());
   } else {
-    hash_table[hash].is_used = true;
+    ExternalKey external = {arena.size(),
+                            static_cast<uint32_t>(key.size()),
+                            static_cast<uint32_t>(hash >> 7)};
+    arena.insert(arena.end(), key.begin(), key.end());
+    WriteExternal(&key_slot, external);
+    key_slot.tag = kExternalKey;
+  }
+  // Слот становится занятым только после того, как ключ записан
+  if (control[slot] == kDeleted) {
+    deleted_number--;
   }
-  // Записываем ключ
-  hash_table[hash].key = key; 
-  // Сохраняем сырой хеш
-  hash_table[hash].raw_hash = raw_hash;
+  control[slot] = static_cast<int8_t>(hash & 0x7F);
   // Увеличиваем счетчик записей в таблице
   entries_number++;
-  // Если коэффициент заполнения больше 0.75, перехешируем таблицу
-  if (entries_number > hash_table.size() * 0.75) {
-    RehashTable();
+  // Если коэффициент заполнения вместе с удаленными слотами больше 0.75,
+  // перехешируем таблицу. Когда записей не больше трех восьмых, хватит
+  // таблицы того же размера, из которой просто пропадут удаленные слоты
+  if (entries_number + deleted_number > control.size() * 0.75) {
+    RehashTable(entries_number > control.size() * 0.375 ? 2 * groups_number
+                                                         : groups_number);
   }
   return true;
 }
@@ -171,68 +257,272 @@ bool HashTable::Add(const std::string& key) {
 // Удаление ключа
 bool HashTable::Remove(const std::string& key) {
   assert(!key.empty());
-  
-  int hash = Hash(&key[0]) % hash_table.size();
-  
-  for (int i = 0; i < hash_table.size(); i++) {
-    hash = (hash + i) % hash_table.size();
-  
-    if (!hash_table[hash].is_used) {
-      break;
-    }
-    // Если нашли ключ и он не удален, помечаем удаленным,
-    // возвращаем true
-    if ((hash_table[hash].key == key) && (!hash_table[hash].is_deleted)) {
-      hash_table[hash].is_deleted=true;
-      // Уменьшаем счетчик записей в таблице
-      entries_number--;
-      return true;
+  size_t slot = FindSlot(key, Hash(key.data(), key.size()));
+  if (slot == kNotFound) {
+    return false;
+  }
+  // Если в группе есть пустой слот, она ни разу не заполнялась целиком
+  // и пробирование через нее не проходило, поэтому слот можно
+  // сделать пустым. Иначе помечаем удаленным
+  const int8_t* group = &control[slot - slot % kGroupSize];
+  if (MatchByte(group, kEmpty)) {
+    control[slot] = kEmpty;
+  } else {
+    control[slot] = kDeleted;
+    deleted_number++;
+  }
+  // Уменьшаем счетчик записей в таблице
+  entries_number--;
+  if (keys[slot].tag == kExternalKey) {
+    dead_bytes += ReadExternal(keys[slot]).length;
+    if ((dead_bytes > kCompactMinBytes) && (2 * dead_bytes > arena.size())) {
+      CompactArena();
     }
   }
-  // Если не нашли ключ
-  return false;
+  return true;
 }
 
-// Хеш-функция
-int HashTable::Hash(const char* str) const {
-  int hash = 0;
-  for ( ; *str != 0; ++str ) {
-    hash = (hash * 233 + *str) % 262144;
+// Хеш-функция: многочлен по схеме Горнера по модулю 2^64,
+// цифры которого - 8-байтные слова строки
+uint64_t HashTable::Hash(const char* str, size_t length) const {
+  const uint64_t kMultiplier = 0x9e3779b97f4a7c15ULL;
+  uint64_t hash = length;
+  const char* end = str + length;
+  uint64_t word = 0;
+  for (; end - str >= 8; str += 8) {
+    memcpy(&word, str, sizeof(word));
+    hash = hash * kMultiplier + word;
+  }
+  // Хвост короче 8 байт дополняем нулями
+  if (str != end) {
+    word = 0;
+    memcpy(&word, str, end - str);
+    hash = hash * kMultiplier + word;
   }
+  // Финальное перемешивание из MurmurHash3, чтобы от всей строки
+  // зависели и отпечаток, и номер группы
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
   return hash;
 }
 
-// Перехеширование таблицы
-void HashTable::RehashTable() {
-  // Создаем новый вектор
-  std::vector<HashTableEntry> new_table(2 * hash_table.size());
-  int hash = 0;
-  // Переносим в цикле все записи без флага is_deleted
-  for (HashTableEntry entry : hash_table) {
-
-    if (entry.is_used) {
-      if (!entry.is_deleted) {
-        hash = entry.raw_hash % new_table.size();
-
-        for (int i = 0; i < new_table.size(); i++) {
-          hash = (hash + i) % new_table.size();
-
-          if (!new_table[hash].is_used) {
-            break;
-          }
-        }
-
-        new_table[hash] = entry;
+uint32_t HashTable::MatchByte(const int8_t* group, int8_t value) {
+#ifdef __SSE2__
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value)));
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupSize; i++) {
+    mask |= static_cast<uint32_t>(group[i] == value) << i;
+  }
+  return mask;
+#endif
+}
+
+uint32_t HashTable::MatchFree(const int8_t* group) {
+  // У пустого и удаленного слота старший бит 1
+#ifdef __SSE2__
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return _mm_movemask_epi8(bytes);
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupSize; i++) {
+    mask |= static_cast<uint32_t>(group[i] < 0) << i;
+  }
+  return mask;
+#endif
+}
+
+uint64_t HashTable::SlotHash(const KeySlot& key_slot,
+                             int8_t fingerprint) const {
+  if (key_slot.tag != kExternalKey) {
+    return Hash(key_slot.bytes, key_slot.tag);
+  }
+  // Отпечаток лежит в управляющем байте, остальные биты - в слоте
+  return (static_cast<uint64_t>(ReadExternal(key_slot).hash) << 7) |
+         static_cast<uint64_t>(fingerprint);
+}
+
+HashTable::ExternalKey HashTable::ReadExternal(const KeySlot& key_slot) {
+  ExternalKey external;
+  uint32_t offset_low = 0;
+  memcpy(&offset_low, key_slot.bytes, 4);
+  memcpy(&external.length, key_slot.bytes + 4, 4);
+  memcpy(&external.hash, key_slot.bytes + 8, 4);
+  uint8_t offset_high = static_cast<uint8_t>(key_slot.bytes[12]);
+  external.offset = (static_cast<uint64_t>(offset_high) << 32) | offset_low;
+  return external;
+}
+
+void HashTable::WriteExternal(KeySlot* key_slot,
+                              const ExternalKey& external) {
+  assert(external.offset < kMaxArenaSize);
+  uint32_t offset_low = static_cast<uint32_t>(external.offset);
+  memcpy(key_slot->bytes, &offset_low, 4);
+  memcpy(key_slot->bytes + 4, &external.length, 4);
+  memcpy(key_slot->bytes + 8, &external.hash, 4);
+  key_slot->bytes[12] = static_cast<char>(external.offset >> 32);
+}
+
+bool HashTable::SlotEquals(const KeySlot& key_slot,
+                           const std::string& key) const {
+  if (key_slot.tag != kExternalKey) {
+    return (key_slot.tag == key.size()) &&
+           (memcmp(key_slot.bytes, key.data(), key.size()) == 0);
+  }
+  ExternalKey external = ReadExternal(key_slot);
+  return (external.length == key.size()) &&
+         (memcmp(&arena[external.offset], key.data(), key.size()) == 0);
+}
+
+size_t HashTable::FindSlot(const std::string& key, uint64_t hash) const {
+  int8_t fingerprint = static_cast<int8_t>(hash & 0x7F);
+  size_t group = (hash >> 7) & (groups_number - 1);
+  // Квадратичное пробирование по группам: g(k, i) = g(k, i-1) + i,
+  // при числе групп - степени двойки обходит все группы
+  for (size_t i = 0; i < groups_number; i++) {
+    group = (group + i) & (groups_number - 1);
+    const int8_t* group_control = &control[group * kGroupSize];
+    uint32_t match = MatchByte(group_control, fingerprint);
+    // Строки сравниваем только в слотах с совпавшим отпечатком
+    for (; match != 0; match &= match - 1) {
+      size_t slot = group * kGroupSize + __builtin_ctz(match);
+      if (SlotEquals(keys[slot], key)) {
+#ifdef HASH_TABLE_PROBE_STATS
+        found_probes[std::min(i, kProbeHistogramSize - 1)]++;
+#endif
+        return slot;
       }
     }
+    // Если в группе есть пустой слот, дальше ключ искать бессмысленно
+    if (MatchByte(group_control, kEmpty)) {
+#ifdef HASH_TABLE_PROBE_STATS
+      missed_probes[std::min(i, kProbeHistogramSize - 1)]++;
+#endif
+      return kNotFound;
+    }
   }
+#ifdef HASH_TABLE_PROBE_STATS
+  missed_probes[kProbeHistogramSize - 1]++;
+#endif
+  return kNotFound;
+}
 
-  // Обновляем хеш-таблицу
-  hash_table = new_table;
+size_t HashTable::FindFreeSlot(uint64_t hash) const {
+  size_t group = (hash >> 7) & (groups_number - 1);
+  for (size_t i = 0; i < groups_number; i++) {
+    group = (group + i) & (groups_number - 1);
+    uint32_t match = MatchFree(&control[group * kGroupSize]);
+    if (match != 0) {
+      return group * kGroupSize + __builtin_ctz(match);
+    }
+  }
+  // Не бывает: заполнение таблицы не больше 0.75
+  assert(false);
+  return kNotFound;
 }
 
+// Перехеширование таблицы
+void HashTable::RehashTable(size_t new_groups_number) {
+  std::vector<int8_t> old_control(new_groups_number * kGroupSize, kEmpty);
+  std::vector<KeySlot> old_keys(new_groups_number * kGroupSize);
+  old_control.swap(control);
+  old_keys.swap(keys);
+  groups_number = new_groups_number;
+  deleted_number = 0;
+  // Переносим только слоты, длинные ключи остаются на месте в буфере
+  for (size_t slot = 0; slot < old_control.size(); slot++) {
+    if (old_control[slot] < 0) continue;
+    uint64_t hash = SlotHash(old_keys[slot], old_control[slot]);
+    size_t new_slot = FindFreeSlot(hash);
+    control[new_slot] = static_cast<int8_t>(hash & 0x7F);
+    keys[new_slot] = old_keys[slot];
+  }
+}
 
-int main() {
+void HashTable::PrintProbeStats(std::ostream& out) const {
+  out << "entries " << entries_number << ", deleted " << deleted_number
+      << ", slots " << control.size() << std::endl;
+#ifndef HASH_TABLE_PROBE_STATS
+  out << "probe histograms are not collected, "
+      << "rebuild with -DHASH_TABLE_PROBE_STATS" << std::endl;
+#else
+  out << "groups probed: found / not found" << std::endl;
+  for (size_t i = 0; i < kProbeHistogramSize; i++) {
+    if ((found_probes[i] == 0) && (missed_probes[i] == 0)) continue;
+    out << i + 1 << (i + 1 == kProbeHistogramSize ? "+" : "") << ": "
+        << found_probes[i] << " / " << missed_probes[i] << std::endl;
+  }
+#endif
+}
+
+// Сжатие буфера: переписываем подряд ключи живых слотов
+void HashTable::CompactArena() {
+  std::vector<char> new_arena;
+  new_arena.reserve(arena.size() - dead_bytes);
+  for (size_t slot = 0; slot < control.size(); slot++) {
+    if ((control[slot] < 0) || (keys[slot].tag != kExternalKey)) continue;
+    ExternalKey external = ReadExternal(keys[slot]);
+    const char* key = &arena[external.offset];
+    external.offset = new_arena.size();
+    new_arena.insert(new_arena.end(), key, key + external.length);
+    WriteExternal(&keys[slot], external);
+  }
+  arena.swap(new_arena);
+  dead_bytes = 0;
+}
+
+
+// Проверка отказа при переполненном буфере длинных ключей: ключ,
+// который не поместился, не должен оставить в таблице занятый слот,
+// а после удаления ключей место должно освобождаться сжатием
+bool ArenaLimitSelfTest() {
+  const size_t kKeySize = 40;
+  HashTable table(8, 4 * kKeySize);
+  std::vector<std::string> stored;
+  for (char c = 'a'; c < 'e'; c++) {
+    stored.push_back(std::string(kKeySize, c));
+    if (!table.Add(stored.back())) return false;
+  }
+  // Буфер полон: все следующие длинные ключи отвергаются, в том числе
+  // после перехеширования, которое вызывают короткие ключи
+  for (int i = 0; i < 1000; i++) {
+    std::string rejected = std::to_string(i) + std::string(kKeySize, 'x');
+    try {
+      table.Add(rejected);
+      return false;
+    } catch (const std::length_error&) {
+    }
+    if (table.Has(rejected) || table.Remove(rejected)) return false;
+    if (!table.Add(std::to_string(i))) return false;
+  }
+  if (table.Size() != 4 + 1000) return false;
+  for (const std::string& key : stored) {
+    if (!table.Has(key)) return false;
+  }
+  // После удаления ключа его байты освобождаются сжатием буфера
+  if (!table.Remove(stored[0])) return false;
+  std::string replacement(kKeySize, 'z');
+  if (!table.Add(replacement) || !table.Has(replacement)) return false;
+  for (size_t i = 1; i < stored.size(); i++) {
+    if (!table.Has(stored[i])) return false;
+  }
+  return table.Size() == 4 + 1000;
+}
+
+int main(int argc, char** argv) {
+  // С флагом --self-test только проверяем таблицу на пределе буфера
+  if ((argc > 1) && (strcmp(argv[1], "--self-test") == 0)) {
+    std::cout << (ArenaLimitSelfTest() ? "OK" : "FAIL") << std::endl;
+    return 0;
+  }
+  // С флагом --probe-stats в конце печатаем статистику пробирования
+  // (гистограммы - только в сборке с -DHASH_TABLE_PROBE_STATS)
+  bool print_probe_stats =
+      (argc > 1) && (strcmp(argv[1], "--probe-stats") == 0);
   HashTable hash_table(8);
   char command = ' ';
   std::string value;
@@ -249,5 +539,8 @@ int main() {
         break;
     }
   }
+  if (print_probe_stats) {
+    hash_table.PrintProbeStats(std::cerr);
+  }
   return 0;
 }